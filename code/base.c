@@ -1,146 +1,924 @@
+//
+// NOTE(cj): OS virtual memory layer. The arena only ever reserves, commits, decommits
+// and releases; everything else is platform independent.
+//
+#if defined(OS_WINDOWS)
+function void *
+m_os_reserve_large_pages(u64 size)
+{
+  // NOTE(cj): large pages cannot be reserved and committed separately on windows.
+  // This also needs SeLockMemoryPrivilege. If we don't have it, this fails and
+  // the caller falls back to normal pages.
+  void *result = 0;
+  if (GetLargePageMinimum())
+  {
+    result = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+  }
+  return(result);
+}
+
+function void *
+m_os_reserve(u64 size, u64 alignment)
+{
+  void *result = 0;
+  if (alignment <= KB(64))
+  {
+    // NOTE(cj): VirtualAlloc reservations are always 64KB aligned
+    result = VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+  }
+  else
+  {
+    // NOTE(cj): reserve enough to find an aligned start in, give it back, and
+    // reserve again right at that start. Another thread can take the range in
+    // between, so try a few times.
+    for (u32 attempt = 0; !result && (attempt < 8); ++attempt)
+    {
+      u8 *probe = VirtualAlloc(0, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+      if (!probe)
+      {
+        break;
+      }
+      VirtualFree(probe, 0, MEM_RELEASE);
+      result = VirtualAlloc((void *)AlignAToB((u64)probe, alignment), size, MEM_RESERVE, PAGE_NOACCESS);
+    }
+  }
+  return(result);
+}
+
+function b32
+m_os_commit(void *ptr, u64 size)
+{
+  b32 result = VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+  return(result);
+}
+
+function void
+m_os_decommit(void *ptr, u64 size)
+{
+  VirtualFree(ptr, size, MEM_DECOMMIT);
+}
+
+function void
+m_os_release(void *ptr, u64 size)
+{
+  (void)size;
+  VirtualFree(ptr, 0, MEM_RELEASE);
+}
+#elif defined(OS_POSIX)
+function void *
+m_os_reserve_large_pages(u64 size)
+{
+  void *result = 0;
+#if defined(MAP_HUGETLB)
+  // NOTE(cj): same as windows, hugetlb pages are populated from a preallocated
+  // pool, so there is no separate commit step.
+  void *block = mmap(0, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (block != MAP_FAILED)
+  {
+    result = block;
+  }
+#else
+  (void)size;
+#endif
+  return(result);
+}
+
+function void *
+m_os_reserve(u64 size, u64 alignment)
+{
+  void *result = 0;
+  u64 map_size = size + ((alignment > 1) ? alignment : 0);
+  u8 *block = mmap(0, map_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (block != MAP_FAILED)
+  {
+    u8 *aligned = block;
+    if (alignment > 1)
+    {
+      // NOTE(cj): trim the slack so the reservation starts and ends on the alignment.
+      aligned = (u8 *)AlignAToB((u64)block, alignment);
+      u64 head = (u64)(aligned - block);
+      u64 tail = map_size - head - size;
+      if (head) munmap(block, head);
+      if (tail) munmap(aligned + size, tail);
+
+#if defined(MADV_HUGEPAGE)
+      madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+    }
+    
+    result = aligned;
+  }
+  
+  return(result);
+}
+
+function b32
+m_os_commit(void *ptr, u64 size)
+{
+  b32 result = mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+  return(result);
+}
+
+function void
+m_os_decommit(void *ptr, u64 size)
+{
+  madvise(ptr, size, MADV_DONTNEED);
+  mprotect(ptr, size, PROT_NONE);
+}
+
+function void
+m_os_release(void *ptr, u64 size)
+{
+  munmap(ptr, size);
+}
+#endif
+
+function b32
+m_arena_commit_range(M_Arena *arena, u64 from, u64 to)
+{
+  b32 result = m_os_commit(arena->base + from, to - from);
+  if (result)
+  {
+    u64 page_size = (arena->flags & M_ArenaFlag_LargePages) ? M_Arena_LargePageSize : KB(4);
+    arena->stats.commit_count += 1;
+    arena->stats.page_fault_count += (to - from + page_size - 1) / page_size;
+  }
+  return(result);
+}
+
+// NOTE(cj): kept out of line, so pop stays a leaf function when it has nothing
+// to give back
+no_inline function void
+m_arena_decommit_to(M_Arena *arena, u64 new_commit_ptr)
+{
+  m_os_decommit(arena->base + new_commit_ptr, arena->commit_ptr - new_commit_ptr);
+  arena->commit_ptr = new_commit_ptr;
+  arena->stats.decommit_count += 1;
+}
+
 function M_Arena *
-m_arena_reserve(u64 reserve_size)
+m_arena_reserve_flags(u64 reserve_size, M_Arena_Flag flags)
 {
   M_Arena *result = 0;
-  reserve_size = AlignAToB(reserve_size, 16);
-  void *block = VirtualAlloc(0, reserve_size, MEM_RESERVE, PAGE_NOACCESS);
+  u64 commit_granularity = M_Arena_DefaultCommit;
+  u32 decommit_after_frames = 0;
+  b32 committed_up_front = 0;
+  u8 *block = 0;
+  
+  if (flags & M_ArenaFlag_LargePages)
+  {
+    commit_granularity = M_Arena_LargePageSize;
+    reserve_size = AlignAToB(reserve_size, M_Arena_LargePageSize);
+    block = m_os_reserve_large_pages(reserve_size);
+    if (block)
+    {
+      flags |= M_ArenaFlag_NoDecommit;
+      committed_up_front = 1;
+    }
+    else
+    {
+      block = m_os_reserve(reserve_size, M_Arena_LargePageSize);
+      decommit_after_frames = M_Arena_LargePageDecommitFrames;
+    }
+  }
+  else
+  {
+    reserve_size = AlignAToB(reserve_size, 16);
+    block = m_os_reserve(reserve_size, 0);
+  }
+  
+  // NOTE(cj): a NoDecommit arena we reserved ourselves still commits as it grows,
+  // it just never gives anything back
+  u64 new_commit_ptr_clamped = reserve_size;
+  if (block && !committed_up_front)
+  {
+    // NOTE(cj): the header lives in the first commit, so without it there is no arena
+    u64 new_commit_ptr = AlignAToB(M_Arena_HeaderSize, commit_granularity);
+    new_commit_ptr_clamped = Min(new_commit_ptr, reserve_size);
+    if (!m_os_commit(block, new_commit_ptr_clamped))
+    {
+      m_os_release(block, reserve_size);
+      block = 0;
+    }
+  }
   
   if (block)
   {
-    u64 new_commit_ptr = AlignAToB(sizeof(M_Arena), M_Arena_DefaultCommit);
-    u64 new_commit_ptr_clamped = Min(new_commit_ptr, reserve_size);
-    
-    VirtualAlloc(block, new_commit_ptr_clamped, MEM_COMMIT, PAGE_READWRITE);
-    result = block;
+    result = (M_Arena *)block;
     result->base = block;
     result->commit_ptr = new_commit_ptr_clamped;
-    result->stack_ptr = sizeof(M_Arena);
+    result->stack_ptr = M_Arena_HeaderSize;
     result->capacity = reserve_size;
+    result->commit_granularity = commit_granularity;
+    result->flags = flags;
+    result->decommit_after_frames = decommit_after_frames;
+    result->frames_below_threshold = 0;
+    result->decommit_slack = 0;
+    result->frame_high_water_ptr = result->stack_ptr;
+    result->window_high_water_ptr = result->stack_ptr;
+    ClearStructP(&result->stats);
+    result->stats.peak_stack_ptr = result->stack_ptr;
+    result->name = (String_U8_Const){0};
+    result->current = result;
+    result->prev = 0;
+    result->spare = 0;
+    result->base_pos = 0;
+    result->scratch_slot = 0;
   }
   
   return(result);
 }
 
+function M_Arena *
+m_arena_reserve(u64 reserve_size)
+{
+  M_Arena *result = m_arena_reserve_flags(reserve_size, 0);
+  return(result);
+}
+
+// NOTE(cj): named arenas, see m_arena_set_name
+global_variable M_Arena *g_arena_registry[M_Arena_MaxRegistered];
+global_variable u64 g_arena_registry_count;
+
+function void
+m_arena_release(M_Arena *arena)
+{
+  Assert(arena);
+  if (arena->name.s)
+  {
+    // NOTE(cj): the slot stays used, the telemetry dump skips empty ones
+    u64 count = Min(g_arena_registry_count, M_Arena_MaxRegistered);
+    for (u64 slot = 0; slot < count; ++slot)
+    {
+      if (g_arena_registry[slot] == arena)
+      {
+        g_arena_registry[slot] = 0;
+      }
+    }
+  }
+  
+  for (M_Arena *block = arena->current; block != arena;)
+  {
+    M_Arena *prev = block->prev;
+    m_os_release(block->base, block->capacity);
+    block = prev;
+  }
+  
+  if (arena->spare)
+  {
+    m_os_release(arena->spare->base, arena->spare->capacity);
+  }
+  
+  m_os_release(arena->base, arena->capacity);
+}
+
+// NOTE(cj): slow path of m_arena_push for chained arenas. The current block is full,
+// so link in a new one (or the spare we kept around from the last pop).
+function void *
+m_arena_push_chain(M_Arena *arena, u64 push_size)
+{
+  void *result_block = 0;
+  M_Arena *block = arena->current;
+  M_Arena *new_block = 0;
+  u64 needed = push_size + M_Arena_HeaderSize;
+  
+  if (arena->spare && (arena->spare->capacity >= needed))
+  {
+    new_block = arena->spare;
+    arena->spare = 0;
+  }
+  else
+  {
+    new_block = m_arena_reserve_flags(Max(arena->capacity, needed), arena->flags & ~M_ArenaFlag_Chained);
+    if (new_block)
+    {
+      new_block->decommit_after_frames = arena->decommit_after_frames;
+      new_block->decommit_slack = arena->decommit_slack;
+    }
+  }
+  
+  if (new_block)
+  {
+    new_block->prev = block;
+    new_block->base_pos = block->base_pos + block->capacity;
+    arena->current = new_block;
+    result_block = m_arena_push(new_block, push_size);
+  }
+  
+  return(result_block);
+}
+
+// NOTE(cj): slow path of m_arena_push, the block has to commit more memory first
+// (or is full). Kept out of line, so the common case doesn't pay for it.
+no_inline function void *
+m_arena_push_commit(M_Arena *arena, u64 push_size)
+{
+  void *result_block = 0;
+  M_Arena *block = arena->current;
+  u64 desired_stack_ptr = block->stack_ptr + push_size;
+  if (desired_stack_ptr <= block->capacity)
+  {
+    u64 new_commit_ptr = AlignAToB(desired_stack_ptr, block->commit_granularity);
+    u64 new_commit_ptr_clamped = Min(new_commit_ptr, block->capacity);
+    if (m_arena_commit_range(block, block->commit_ptr, new_commit_ptr_clamped))
+    {
+      block->commit_ptr = new_commit_ptr_clamped;
+      result_block = m_arena_push(arena, push_size);
+    }
+  }
+  
+  if (!result_block && (arena->flags & M_ArenaFlag_Chained))
+  {
+    result_block = m_arena_push_chain(arena, push_size);
+  }
+  
+  return(result_block);
+}
+
 function void *
 m_arena_push(M_Arena *arena, u64 push_size)
 {
   Assert(arena);
+  M_Arena *block = arena->current;
   void *result_block = 0;
   push_size = AlignAToB(push_size, 16);
-  u64 desired_stack_ptr = arena->stack_ptr + push_size;
-  u64 desired_commit_ptr = arena->commit_ptr;
-  if (desired_stack_ptr <= arena->capacity)
+  u64 desired_stack_ptr = block->stack_ptr + push_size;
+  if (desired_stack_ptr <= block->commit_ptr)
+  {
+    result_block = block->base + block->stack_ptr;
+    block->stack_ptr = desired_stack_ptr;
+    
+#if defined(DR_ARENA_TELEMETRY)
+    block->stats.push_count += 1;
+    block->stats.largest_push = Max(block->stats.largest_push, push_size);
+#endif
+  }
+  else
+  {
+    result_block = m_arena_push_commit(arena, push_size);
+  }
+  
+  Assert(result_block);
+  return(result_block);
+}
+
+// NOTE(cj): grows an allocation from old_size to new_size. If it is the last thing
+// pushed on the arena it is extended in place, otherwise it is copied to a new push
+// and the old bytes are left behind.
+function void *
+m_arena_grow(M_Arena *arena, void *data, u64 old_size, u64 new_size)
+{
+  void *result = 0;
+  old_size = AlignAToB(old_size, 16);
+  new_size = AlignAToB(new_size, 16);
+  
+  M_Arena *block = arena->current;
+  u8 *arena_top = block->base + block->stack_ptr;
+  if (data && ((u8 *)data + old_size == arena_top))
+  {
+    u8 *extension = m_arena_push(arena, new_size - old_size);
+    if (extension == arena_top)
+    {
+      result = data;
+    }
+    else
+    {
+      // NOTE(cj): a chained arena moved on to a new block. Give the extension
+      // back and fall through to the copy.
+      m_arena_pop(arena, new_size - old_size);
+    }
+  }
+  
+  if (!result)
+  {
+    result = m_arena_push(arena, new_size);
+    if (data)
+    {
+      MemoryCopy(result, data, old_size);
+    }
+  }
+  
+  return(result);
+}
+
+function void
+m_arena_pop_block(M_Arena *block, u64 pop_size)
+{
+  pop_size = AlignAToB(pop_size, 16);
+  Assert(pop_size <= (block->stack_ptr - M_Arena_HeaderSize));
+  
+  // NOTE(cj): the frame's peak is always reached right before a pop (or at the end
+  // of the frame), so the push path doesn't need to track it.
+  block->frame_high_water_ptr = Max(block->frame_high_water_ptr, block->stack_ptr);
+  block->stack_ptr -= pop_size;
+  
+  if (!(block->flags & M_ArenaFlag_NoDecommit) && !block->decommit_after_frames)
+  {
+    u64 new_commit_ptr = AlignAToB(block->stack_ptr, block->commit_granularity);
+    if (new_commit_ptr < block->commit_ptr)
+    {
+      m_arena_decommit_to(block, new_commit_ptr);
+    }
+  }
+}
+
+inline function u64
+m_arena_pos(M_Arena *arena)
+{
+  M_Arena *block = arena->current;
+  u64 result = block->base_pos + block->stack_ptr;
+  return(result);
+}
+
+function void
+m_arena_pop_to(M_Arena *arena, u64 pos)
+{
+  M_Arena *block = arena->current;
+  
+  // NOTE(cj): drop every block that starts at or after pos. Keep the most recent one
+  // around, so an arena that keeps crossing a block boundary doesn't thrash the OS.
+  while ((block != arena) && (pos < (block->base_pos + M_Arena_HeaderSize)))
+  {
+    M_Arena *prev = block->prev;
+    m_arena_pop_block(block, block->stack_ptr - M_Arena_HeaderSize);
+    if (arena->spare)
+    {
+      m_os_release(arena->spare->base, arena->spare->capacity);
+    }
+    arena->spare = block;
+    block = prev;
+  }
+  arena->current = block;
+  
+  u64 new_stack_ptr = Max(pos - block->base_pos, M_Arena_HeaderSize);
+  if (new_stack_ptr < block->stack_ptr)
+  {
+    m_arena_pop_block(block, block->stack_ptr - new_stack_ptr);
+  }
+}
+
+// NOTE(cj): positions skip the unused tail and the header of every block boundary,
+// so pop_size can't just be subtracted from the position. Walk back over the
+// bytes that are actually in use instead. A block that ends up empty is dropped,
+// the same as m_arena_pop_to does, so pop lands on the position the matching
+// push started at.
+function void
+m_arena_pop(M_Arena *arena, u64 pop_size)
+{
+  pop_size = AlignAToB(pop_size, 16);
+  M_Arena *block = arena->current;
+  if ((pop_size < (block->stack_ptr - M_Arena_HeaderSize)) || (block == arena))
+  {
+    m_arena_pop_block(block, pop_size);
+  }
+  else
+  {
+    while ((block != arena) && (pop_size >= (block->stack_ptr - M_Arena_HeaderSize)))
+    {
+      pop_size -= block->stack_ptr - M_Arena_HeaderSize;
+      block = block->prev;
+    }
+    Assert(pop_size <= (block->stack_ptr - M_Arena_HeaderSize));
+    m_arena_pop_to(arena, block->base_pos + block->stack_ptr - pop_size);
+  }
+}
+
+function void
+m_arena_set_decommit_hysteresis(M_Arena *arena, u32 frames, u64 slack)
+{
+  arena->decommit_after_frames = frames;
+  arena->frames_below_threshold = 0;
+  arena->decommit_slack = AlignAToB(slack, arena->commit_granularity);
+  arena->stats.peak_stack_ptr = Max(arena->stats.peak_stack_ptr, arena->frame_high_water_ptr);
+  arena->frame_high_water_ptr = arena->stack_ptr;
+  arena->window_high_water_ptr = arena->stack_ptr;
+}
+
+function void
+m_arena_end_frame(M_Arena *arena)
+{
+  // NOTE(cj): only the newest block of a chain is ever partially used
+  arena = arena->current;
+  if (!(arena->flags & M_ArenaFlag_NoDecommit) && arena->decommit_after_frames)
+  {
+    u64 frame_peak = Max(arena->frame_high_water_ptr, arena->stack_ptr);
+    u64 needed_commit_ptr = AlignAToB(frame_peak, arena->commit_granularity);
+    if ((needed_commit_ptr + arena->decommit_slack) < arena->commit_ptr)
+    {
+      arena->window_high_water_ptr = Max(arena->window_high_water_ptr, frame_peak);
+      if (++arena->frames_below_threshold >= arena->decommit_after_frames)
+      {
+        // NOTE(cj): keep whatever the busiest frame of the window needed
+        u64 new_commit_ptr = AlignAToB(arena->window_high_water_ptr, arena->commit_granularity);
+        if (new_commit_ptr < arena->commit_ptr)
+        {
+          m_arena_decommit_to(arena, new_commit_ptr);
+        }
+        
+        arena->frames_below_threshold = 0;
+        arena->window_high_water_ptr = arena->stack_ptr;
+      }
+    }
+    else
+    {
+      arena->frames_below_threshold = 0;
+      arena->window_high_water_ptr = arena->stack_ptr;
+    }
+  }
+  
+  arena->stats.peak_stack_ptr = Max(arena->stats.peak_stack_ptr, Max(arena->frame_high_water_ptr, arena->stack_ptr));
+  arena->frame_high_water_ptr = arena->stack_ptr;
+}
+
+global_variable FILE *g_arena_telemetry_file;
+global_variable b32 g_arena_telemetry_binary;
+
+function void
+m_arena_set_name(M_Arena *arena, String_U8_Const name)
+{
+  Assert(arena);
+  b32 first_time = (arena->name.s == 0);
+  arena->name = name;
+  
+  if (first_time)
+  {
+    // NOTE(cj): every thread registers its own scratch arenas, so running out of
+    // registry slots is not an error. The extra arenas just go unreported.
+    u64 slot = AtomicIncEvalU64(&g_arena_registry_count) - 1;
+    if (slot < M_Arena_MaxRegistered)
+    {
+      g_arena_registry[slot] = arena;
+    }
+  }
+}
+
+function M_Arena_Telemetry
+m_arena_get_telemetry(M_Arena *arena)
+{
+  M_Arena_Telemetry result = {0};
+  result.name = arena->name;
+  
+  // NOTE(cj): chained arenas report the sum over every live block
+  for (M_Arena *block = arena->current; block; block = block->prev)
+  {
+    result.current_bytes += block->stack_ptr - M_Arena_HeaderSize;
+    u64 peak_stack_ptr = Max(block->stats.peak_stack_ptr, Max(block->frame_high_water_ptr, block->stack_ptr));
+    result.peak_bytes += peak_stack_ptr - M_Arena_HeaderSize;
+    result.committed_bytes += block->commit_ptr;
+    result.reserved_bytes += block->capacity;
+    result.push_count += block->stats.push_count;
+    result.largest_push = Max(result.largest_push, block->stats.largest_push);
+  }
+  
+  return(result);
+}
+
+function u64
+m_arena_registered_count(void)
+{
+  u64 result = Min(g_arena_registry_count, M_Arena_MaxRegistered);
+  return(result);
+}
+
+function M_Arena *
+m_arena_registered(u64 index)
+{
+  M_Arena *result = 0;
+  if (index < m_arena_registered_count())
+  {
+    result = g_arena_registry[index];
+  }
+  return(result);
+}
+
+function b32
+m_arena_telemetry_open_dump(char *path, b32 binary)
+{
+  m_arena_telemetry_close_dump();
+  g_arena_telemetry_file = fopen(path, binary ? "wb" : "w");
+  g_arena_telemetry_binary = binary;
+  if (g_arena_telemetry_file && !binary)
+  {
+    fprintf(g_arena_telemetry_file, "frame,name,current_bytes,peak_bytes,committed_bytes,reserved_bytes,push_count,largest_push\n");
+  }
+  
+  return(g_arena_telemetry_file != 0);
+}
+
+function void
+m_arena_telemetry_dump_frame(u64 frame_index)
+{
+  FILE *file = g_arena_telemetry_file;
+  if (file)
+  {
+    u64 count = m_arena_registered_count();
+    for (u64 arena_idx = 0; arena_idx < count; ++arena_idx)
+    {
+      M_Arena *arena = g_arena_registry[arena_idx];
+      if (!arena)
+      {
+        continue;
+      }
+      
+      M_Arena_Telemetry t = m_arena_get_telemetry(arena);
+      if (g_arena_telemetry_binary)
+      {
+        M_Arena_TelemetryRecord record = {0};
+        record.frame_index = frame_index;
+        MemoryCopy(record.name, t.name.s, Min(t.name.count, sizeof(record.name) - 1));
+        record.current_bytes = t.current_bytes;
+        record.peak_bytes = t.peak_bytes;
+        record.committed_bytes = t.committed_bytes;
+        record.reserved_bytes = t.reserved_bytes;
+        record.push_count = t.push_count;
+        record.largest_push = t.largest_push;
+        fwrite(&record, sizeof(record), 1, file);
+      }
+      else
+      {
+        fprintf(file, "%llu,%.*s,%llu,%llu,%llu,%llu,%llu,%llu\n",
+                (unsigned long long)frame_index, (int)t.name.count, (char *)t.name.s,
+                (unsigned long long)t.current_bytes, (unsigned long long)t.peak_bytes,
+                (unsigned long long)t.committed_bytes, (unsigned long long)t.reserved_bytes,
+                (unsigned long long)t.push_count, (unsigned long long)t.largest_push);
+      }
+    }
+    
+    // NOTE(cj): the game leaves through ExitProcess, which does not flush stdio.
+    fflush(file);
+  }
+}
+
+function void
+m_arena_telemetry_close_dump(void)
+{
+  if (g_arena_telemetry_file)
+  {
+    fclose(g_arena_telemetry_file);
+    g_arena_telemetry_file = 0;
+  }
+}
+
+inline function void
+m_arena_clear(M_Arena *arena)
+{
+  m_arena_pop_to(arena, M_Arena_HeaderSize);
+}
+
+inline function Temporary_Memory
+begin_temporary_memory(M_Arena *arena)
+{
+  Assert(!!arena);
+  Temporary_Memory result;
+  result.arena = arena;
+  result.start_pos = m_arena_pos(arena);
+  return(result);
+}
+
+inline function void
+end_temporary_memory(Temporary_Memory temp)
+{
+  Assert(!!temp.arena);
+  Assert(m_arena_pos(temp.arena) >= temp.start_pos);
+  m_arena_pop_to(temp.arena, temp.start_pos);
+}
+
+//
+// NOTE(cj): Scratch arenas. Every thread lazily gets its own pool of them. Each
+// scratch arena remembers its slot in the pool, so the conflicts only need to be
+// walked once to build a mask of the slots we can't use.
+//
+global_variable thread_variable Scratch_Pool g_scratch_pool;
+
+function M_Arena *
+scratch_get_arena(M_Arena **conflicts, u64 count)
+{
+  Scratch_Pool *pool = &g_scratch_pool;
+  
+  u64 taken_mask = 0;
+  for (u64 conflict_idx = 0; conflict_idx < count; ++conflict_idx)
+  {
+    M_Arena *conflict = conflicts[conflict_idx];
+    if (conflict && conflict->scratch_slot && (pool->arenas[conflict->scratch_slot - 1] == conflict))
+    {
+      taken_mask |= 1llu << (conflict->scratch_slot - 1);
+    }
+  }
+  
+  M_Arena *result = 0;
+  u64 slot = CountTrailingZerosU64(~taken_mask);
+  Assert(slot < Scratch_MaxArenas);
+  if (slot < Scratch_MaxArenas)
   {
-    if (desired_stack_ptr >= arena->commit_ptr)
+    if (!pool->arenas[slot])
     {
-      u64 new_commit_ptr = AlignAToB(desired_stack_ptr, M_Arena_DefaultCommit);
-      u64 new_commit_ptr_clamped = Min(new_commit_ptr, arena->capacity);
+      String_U8_Const scratch_names[Scratch_MaxArenas] =
+      {
+        str8("scratch 0"), str8("scratch 1"), str8("scratch 2"), str8("scratch 3"),
+        str8("scratch 4"), str8("scratch 5"), str8("scratch 6"), str8("scratch 7"),
+      };
       
-      if (new_commit_ptr_clamped > arena->commit_ptr)
+      // NOTE(cj): large page reservations fail when the 2MB aligned address space
+      // or the commit runs out before a normal one would. Scratch memory works
+      // without them, so try again the plain way before giving up.
+      M_Arena *arena = m_arena_reserve_flags(Scratch_ArenaSize, M_ArenaFlag_LargePages);
+      if (!arena)
       {
-        VirtualAlloc(arena->base + arena->commit_ptr,
-                     new_commit_ptr_clamped - arena->commit_ptr,
-                     MEM_COMMIT, PAGE_READWRITE);
-        desired_commit_ptr = new_commit_ptr_clamped;
+        arena = m_arena_reserve(Scratch_ArenaSize);
+      }
+      
+      if (arena)
+      {
+        arena->scratch_slot = (u32)(slot + 1);
+        m_arena_set_name(arena, scratch_names[slot]);
+        pool->arenas[slot] = arena;
       }
     }
     
-    if (desired_commit_ptr > desired_stack_ptr)
-    {
-      result_block = arena->base + arena->stack_ptr;
-      arena->stack_ptr = desired_stack_ptr;
-      arena->commit_ptr = desired_commit_ptr;
-    }
+    result = pool->arenas[slot];
   }
   
-  Assert(result_block);
-  return(result_block);
+  return(result);
+}
+
+function Temporary_Memory
+scratch_begin(M_Arena **conflicts, u64 count)
+{
+  Temporary_Memory result = begin_temporary_memory(scratch_get_arena(conflicts, count));
+  return(result);
 }
 
 function void
-m_arena_pop(M_Arena *arena, u64 pop_size)
+scratch_end_frame(void)
 {
-  pop_size = AlignAToB(pop_size, 16);
-  Assert(pop_size <= (arena->stack_ptr + sizeof(M_Arena)));
-  arena->stack_ptr -= pop_size;
-  
-  u64 new_commit_ptr = AlignAToB(arena->stack_ptr, M_Arena_DefaultCommit);
-  if (new_commit_ptr < arena->commit_ptr)
+  Scratch_Pool *pool = &g_scratch_pool;
+  for (u64 slot = 0; slot < Scratch_MaxArenas; ++slot)
   {
-    VirtualFree(arena->base + new_commit_ptr, arena->commit_ptr - new_commit_ptr, MEM_DECOMMIT);
-    arena->commit_ptr = new_commit_ptr;
+    if (pool->arenas[slot])
+    {
+      m_arena_end_frame(pool->arenas[slot]);
+    }
   }
 }
 
-inline function void
-m_arena_clear(M_Arena *arena)
+function void
+m_pool_init(M_Pool *pool, M_Arena *arena, u64 element_size, u64 slots_per_chunk)
 {
-  u64 arena_size = sizeof(M_Arena);
-  if (arena->stack_ptr > arena_size)
-  {
-    m_arena_pop(arena, arena->stack_ptr - arena_size);
-  }
+  Assert(arena && element_size && slots_per_chunk);
+  pool->arena = arena;
+  pool->slot_stride = M_Pool_SlotHeaderSize + AlignAToB(element_size, 16);
+  pool->slots_per_chunk = slots_per_chunk;
+  pool->chunks = 0;
+  pool->chunk_count = 0;
+  pool->chunk_capacity = 0;
+  pool->next_unused_in_chunk = slots_per_chunk;
+  pool->free_list = 0;
+  pool->live_count = 0;
 }
 
-inline function Temporary_Memory
-begin_temporary_memory(M_Arena *arena)
+inline function M_Pool_Slot *
+m_pool_slot_from_element(void *element)
 {
-  Assert(!!arena);
-  Temporary_Memory result;
-  result.arena = arena;
-  result.start_stack_ptr = arena->stack_ptr;
+  M_Pool_Slot *result = (M_Pool_Slot *)((u8 *)element - M_Pool_SlotHeaderSize);
   return(result);
 }
 
-inline function void
-end_temporary_memory(Temporary_Memory temp)
+inline function M_Pool_Slot *
+m_pool_slot_from_index(M_Pool *pool, u64 index)
 {
-  Assert(!!temp.arena);
-  Assert(temp.arena->stack_ptr >= temp.start_stack_ptr);
-  m_arena_pop(temp.arena, temp.arena->stack_ptr - temp.start_stack_ptr);
+  u64 chunk_idx = index / pool->slots_per_chunk;
+  u64 slot_idx = index % pool->slots_per_chunk;
+  M_Pool_Slot *result = (M_Pool_Slot *)(pool->chunks[chunk_idx] + slot_idx * pool->slot_stride);
+  return(result);
 }
 
-#define MaxTransientArena() 4
-global_variable thread_variable M_Arena *g_transient_arena[MaxTransientArena()];
+inline function u64
+m_pool_slot_count(M_Pool *pool)
+{
+  u64 result = 0;
+  if (pool->chunk_count)
+  {
+    result = (pool->chunk_count - 1) * pool->slots_per_chunk + pool->next_unused_in_chunk;
+  }
+  return(result);
+}
 
-function M_Arena *
-get_transient_arena(M_Arena **conflict, u64 count)
+function void *
+m_pool_alloc(M_Pool *pool)
 {
-  if (!g_transient_arena[0])
+  M_Pool_Slot *slot = pool->free_list;
+  if (slot)
   {
-    for (u64 arena_idx = 0; arena_idx < MaxTransientArena(); ++arena_idx)
-    {
-      g_transient_arena[arena_idx] = m_arena_reserve(MB(8));
-    }
+    pool->free_list = slot->next_free;
   }
-  
-  M_Arena *result = 0;
-  for (u64 arena_idx = 0; arena_idx < MaxTransientArena(); ++arena_idx)
+  else
   {
-    b32 accept_selection = 1;
-    
-    for (u64 conflict_idx = 0; conflict_idx < count; ++conflict_idx)
+    if (pool->next_unused_in_chunk == pool->slots_per_chunk)
     {
-      if (g_transient_arena[arena_idx] == conflict[conflict_idx])
+      if (pool->chunk_count == pool->chunk_capacity)
       {
-        accept_selection = 0;
-        break;
+        u64 new_capacity = pool->chunk_capacity ? (pool->chunk_capacity * 2) : 16;
+        u8 **new_chunks = M_Arena_PushArray(pool->arena, u8 *, new_capacity);
+        if (pool->chunk_count)
+        {
+          MemoryCopy(new_chunks, pool->chunks, sizeof(u8 *) * pool->chunk_count);
+        }
+        pool->chunks = new_chunks;
+        pool->chunk_capacity = new_capacity;
       }
+      
+      pool->chunks[pool->chunk_count++] = m_arena_push(pool->arena, pool->slot_stride * pool->slots_per_chunk);
+      pool->next_unused_in_chunk = 0;
     }
     
-    if (accept_selection)
+    u64 index = (pool->chunk_count - 1) * pool->slots_per_chunk + pool->next_unused_in_chunk++;
+    slot = m_pool_slot_from_index(pool, index);
+    slot->generation = 0;
+    slot->index = (u32)index;
+  }
+  
+  Assert(!(slot->generation & 1));
+  slot->generation += 1;
+  slot->next_free = 0;
+  pool->live_count += 1;
+  
+  void *result = (u8 *)slot + M_Pool_SlotHeaderSize;
+  return(result);
+}
+
+function void
+m_pool_free(M_Pool *pool, void *element)
+{
+  Assert(element);
+  M_Pool_Slot *slot = m_pool_slot_from_element(element);
+  Assert(slot->generation & 1);
+  slot->generation += 1;
+  slot->next_free = pool->free_list;
+  pool->free_list = slot;
+  pool->live_count -= 1;
+}
+
+function void
+m_pool_free_many(M_Pool *pool, void **elements, u64 count)
+{
+  for (u64 element_idx = 0; element_idx < count; ++element_idx)
+  {
+    m_pool_free(pool, elements[element_idx]);
+  }
+}
+
+function void
+m_pool_reset(M_Pool *pool)
+{
+  // NOTE(cj): rebuild the free list from scratch. Outstanding handles go stale
+  // because every live slot gets its generation bumped.
+  pool->free_list = 0;
+  u64 slot_count = m_pool_slot_count(pool);
+  for (u64 index = slot_count; index > 0; --index)
+  {
+    M_Pool_Slot *slot = m_pool_slot_from_index(pool, index - 1);
+    if (slot->generation & 1)
     {
-      result = g_transient_arena[arena_idx];
-      break;
+      slot->generation += 1;
+    }
+    slot->next_free = pool->free_list;
+    pool->free_list = slot;
+  }
+  pool->live_count = 0;
+}
+
+function M_Pool_Handle
+m_pool_handle(M_Pool *pool, void *element)
+{
+  (void)pool;
+  M_Pool_Slot *slot = m_pool_slot_from_element(element);
+  M_Pool_Handle result;
+  result.index = slot->index;
+  result.generation = slot->generation;
+  return(result);
+}
+
+function void *
+m_pool_get(M_Pool *pool, M_Pool_Handle handle)
+{
+  void *result = 0;
+  u64 slot_count = m_pool_slot_count(pool);
+  if (handle.index < slot_count)
+  {
+    M_Pool_Slot *slot = m_pool_slot_from_index(pool, handle.index);
+    if ((slot->generation == handle.generation) && (handle.generation & 1))
+    {
+      result = (u8 *)slot + M_Pool_SlotHeaderSize;
     }
   }
-  
-  Assert(result);
   return(result);
 }
 
+// NOTE(cj): the old two-pass formatter. Only used for the specifiers the fast
+// path below doesn't know about (widths, flags, %e, %g, %p...).
 function String_U8_Const
-str8_format_va(M_Arena *arena, String_U8_Const str, va_list args0)
+str8_format_va_crt(M_Arena *arena, String_U8_Const str, va_list args0)
 {
   va_list args1;
   va_copy(args1, args0);
@@ -152,7 +930,9 @@ str8_format_va(M_Arena *arena, String_U8_Const str, va_list args0)
     result.count = (u64)total_chars;
     result.cap = result.count;
     result.s = M_Arena_PushArray(arena, u8, result.cap + 1);
-    vsnprintf((char *)result.s, result.count + 1, (char *)str.s, args1);
+    // NOTE(cj): args1 was consumed by the measuring pass. That happens to work with
+    // msvc's va_list, but not with the SysV one.
+    vsnprintf((char *)result.s, result.count + 1, (char *)str.s, args0);
     
     result.s[result.count] = 0;
   }
@@ -161,6 +941,328 @@ str8_format_va(M_Arena *arena, String_U8_Const str, va_list args0)
   return(result);
 }
 
+global_variable char str8_digit_pairs[201] =
+"00010203040506070809"
+"10111213141516171819"
+"20212223242526272829"
+"30313233343536373839"
+"40414243444546474849"
+"50515253545556575859"
+"60616263646566676869"
+"70717273747576777879"
+"80818283848586878889"
+"90919293949596979899";
+
+global_variable u64 str8_powers_of_ten[10] =
+{
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+// NOTE(cj): writes v into the end of buffer (at least 20 bytes) and returns the
+// number of digits written. Two digits per division.
+function u64
+str8_write_u64_backwards(u8 *one_past_last, u64 v)
+{
+  u8 *at = one_past_last;
+  while (v >= 100)
+  {
+    u64 pair = (v % 100) * 2;
+    v /= 100;
+    at -= 2;
+    at[0] = str8_digit_pairs[pair];
+    at[1] = str8_digit_pairs[pair + 1];
+  }
+  
+  if (v >= 10)
+  {
+    at -= 2;
+    at[0] = str8_digit_pairs[v * 2];
+    at[1] = str8_digit_pairs[v * 2 + 1];
+  }
+  else
+  {
+    *--at = (u8)('0' + v);
+  }
+  
+  u64 result = (u64)(one_past_last - at);
+  return(result);
+}
+
+function u64
+str8_write_hex_backwards(u8 *one_past_last, u64 v, b32 upper)
+{
+  char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  u8 *at = one_past_last;
+  do
+  {
+    *--at = (u8)digits[v & 0xF];
+    v >>= 4;
+  } while (v);
+  
+  u64 result = (u64)(one_past_last - at);
+  return(result);
+}
+
+typedef struct
+{
+  M_Arena *arena;
+  u8 *s;
+  u64 count;
+  u64 cap;
+} Str8_Writer;
+
+inline function u8 *
+str8_writer_reserve(Str8_Writer *w, u64 count)
+{
+  if ((w->count + count) > w->cap)
+  {
+    u64 new_cap = Max(w->cap * 2, w->count + count);
+    w->s = m_arena_grow(w->arena, w->s, w->cap, new_cap);
+    w->cap = new_cap;
+  }
+  
+  u8 *result = w->s + w->count;
+  return(result);
+}
+
+inline function void
+str8_writer_append(Str8_Writer *w, u8 *src, u64 count)
+{
+  u8 *dest = str8_writer_reserve(w, count);
+  MemoryCopy(dest, src, count);
+  w->count += count;
+}
+
+// NOTE(cj): fixed point through a u64, so the value times 10^precision has to fit
+// in the mantissa. Rounds to nearest, ties to even, like printf. Returns 0 when the
+// value can't be handled; the caller falls back to the crt then.
+function b32
+str8_writer_append_f64(Str8_Writer *w, f64 v, u32 precision)
+{
+  b32 result = 0;
+  if ((precision < ArrayCount(str8_powers_of_ten)) && (v == v))
+  {
+    u64 bits;
+    MemoryCopy(&bits, &v, sizeof(bits));
+    b32 negative = (b32)(bits >> 63);
+    f64 magnitude = negative ? -v : v;
+    u64 scale = str8_powers_of_ten[precision];
+    f64 scaled = magnitude * (f64)scale;
+    if (scaled < 4.0e15)
+    {
+      // NOTE(cj): printf rounds the exact product, scaled is rounded already. fma
+      // gives the rounding error exactly, and below 2^52 the fraction of scaled is
+      // exact too, so only a fraction of exactly 0.5 needs the error to decide.
+      f64 scaled_error = fma(magnitude, (f64)scale, -scaled);
+      u64 fixed = (u64)scaled;
+      f64 remainder = scaled - (f64)fixed;
+      if ((remainder > 0.5) ||
+          ((remainder == 0.5) && ((scaled_error > 0) || ((scaled_error == 0) && (fixed & 1)))))
+      {
+        fixed += 1;
+      }
+      u64 whole = fixed / scale;
+      u64 fraction = fixed % scale;
+      
+      u8 buffer[64];
+      u8 *one_past_last = buffer + sizeof(buffer);
+      u8 *at = one_past_last;
+      if (precision)
+      {
+        u64 written = str8_write_u64_backwards(at, fraction);
+        at -= written;
+        for (; written < precision; ++written)
+        {
+          *--at = '0';
+        }
+        *--at = '.';
+      }
+      at -= str8_write_u64_backwards(at, whole);
+      if (negative)
+      {
+        *--at = '-';
+      }
+      
+      str8_writer_append(w, at, (u64)(one_past_last - at));
+      result = 1;
+    }
+  }
+  
+  return(result);
+}
+
+//
+// NOTE(cj): single pass printf. Understands %%, %c, %s, %d/%i, %u, %x/%X with the
+// h/hh/l/ll/z length modifiers, and %f/%.Nf. Anything else (widths, flags, a
+// precision on anything but %f, ...) makes the whole string go through vsnprintf
+// instead.
+//
+function String_U8_Const
+str8_format_va(M_Arena *arena, String_U8_Const str, va_list args0)
+{
+  va_list args;
+  va_copy(args, args0);
+  
+  // NOTE(cj): the writer may have moved to a copy by the time we find out we
+  // can't format this, so the fallback pops back to here rather than by size
+  u64 start_pos = m_arena_pos(arena);
+  Str8_Writer w = {0};
+  w.arena = arena;
+  w.cap = str.count + 32;
+  w.s = M_Arena_PushArray(arena, u8, w.cap);
+  
+  b32 unsupported = 0;
+  u8 *at = str.s;
+  u8 *one_past_last = str.s + str.count;
+  while ((at < one_past_last) && !unsupported)
+  {
+    u8 *literal_start = at;
+    while ((at < one_past_last) && (*at != '%'))
+    {
+      ++at;
+    }
+    str8_writer_append(&w, literal_start, (u64)(at - literal_start));
+    
+    if (at < one_past_last)
+    {
+      ++at;
+      
+      u32 precision = 6;
+      b32 has_precision = 0;
+      if ((at < one_past_last) && (*at == '.'))
+      {
+        ++at;
+        precision = 0;
+        has_precision = 1;
+        while ((at < one_past_last) && (*at >= '0') && (*at <= '9'))
+        {
+          precision = precision * 10 + (u32)(*at++ - '0');
+        }
+      }
+      
+      u32 long_count = 0;
+      u32 short_count = 0;
+      b32 size_t_length = 0;
+      while ((at < one_past_last) && ((*at == 'l') || (*at == 'h') || (*at == 'z')))
+      {
+        long_count += (*at == 'l');
+        short_count += (*at == 'h');
+        size_t_length |= (*at == 'z');
+        ++at;
+      }
+      
+      u8 conversion = (at < one_past_last) ? *at++ : 0;
+      if (has_precision && (conversion != 'f'))
+      {
+        // NOTE(cj): %.3s, %.5d and friends go through the crt (default case)
+        conversion = 0;
+      }
+      
+      u8 buffer[24];
+      u8 *buffer_end = buffer + sizeof(buffer);
+      switch (conversion)
+      {
+        case '%':
+        {
+          str8_writer_append(&w, (u8 *)"%", 1);
+        } break;
+        
+        case 'c':
+        {
+          u8 c = (u8)va_arg(args, int);
+          str8_writer_append(&w, &c, 1);
+        } break;
+        
+        case 's':
+        {
+          char *s = va_arg(args, char *);
+          if (!s)
+          {
+            s = "(null)";
+          }
+          str8_writer_append(&w, (u8 *)s, strlen(s));
+        } break;
+        
+        case 'd':
+        case 'i':
+        {
+          s64 v;
+          if (size_t_length)        v = (s64)va_arg(args, size_t);
+          else if (long_count >= 2) v = (s64)va_arg(args, long long);
+          else if (long_count == 1) v = (s64)va_arg(args, long);
+          else                      v = (s64)va_arg(args, int);
+          
+          // NOTE(cj): h and hh args arrive promoted to int, printf converts back
+          if (short_count >= 2)      v = (s8)v;
+          else if (short_count == 1) v = (s16)v;
+          
+          u64 magnitude = (v < 0) ? (0 - (u64)v) : (u64)v;
+          u8 *digits = buffer_end - str8_write_u64_backwards(buffer_end, magnitude);
+          if (v < 0)
+          {
+            *--digits = '-';
+          }
+          str8_writer_append(&w, digits, (u64)(buffer_end - digits));
+        } break;
+        
+        case 'u':
+        case 'x':
+        case 'X':
+        {
+          u64 v;
+          if (size_t_length)        v = (u64)va_arg(args, size_t);
+          else if (long_count >= 2) v = (u64)va_arg(args, unsigned long long);
+          else if (long_count == 1) v = (u64)va_arg(args, unsigned long);
+          else                      v = (u64)va_arg(args, unsigned int);
+          
+          if (short_count >= 2)      v = (u8)v;
+          else if (short_count == 1) v = (u16)v;
+          
+          u64 written = (conversion == 'u') ? str8_write_u64_backwards(buffer_end, v) : str8_write_hex_backwards(buffer_end, v, conversion == 'X');
+          str8_writer_append(&w, buffer_end - written, written);
+        } break;
+        
+        case 'f':
+        {
+          f64 v = va_arg(args, f64);
+          unsupported = !str8_writer_append_f64(&w, v, precision);
+        } break;
+        
+        default:
+        {
+          unsupported = 1;
+        } break;
+      }
+    }
+  }
+  
+  String_U8_Const result = {0};
+  if (unsupported)
+  {
+    m_arena_pop_to(arena, start_pos);
+    result = str8_format_va_crt(arena, str, args0);
+  }
+  else
+  {
+    u8 *terminator = str8_writer_reserve(&w, 1);
+    *terminator = 0;
+    
+    // NOTE(cj): give back what the worst case guess didn't use
+    u64 used = AlignAToB(w.count + 1, 16);
+    if (w.cap > used)
+    {
+      m_arena_pop(arena, w.cap - used);
+    }
+    
+    result.s = w.s;
+    result.count = w.count;
+    result.cap = w.count;
+  }
+  
+  va_end(args);
+  return(result);
+}
+
 function String_U8_Const
 str8_format(M_Arena *arena, String_U8_Const string, ...)
 {
@@ -173,14 +1275,99 @@ str8_format(M_Arena *arena, String_U8_Const string, ...)
   return(result);
 }
 
+// NOTE(cj): wyhash (final version 4). Eats 16 bytes per step, 48 when the string is
+// long, and every input byte goes through a full 64x64->128 multiply, so
+// identifiers that only differ at the start or the end still land far apart.
+global_variable u64 str8_hash_secret[4] =
+{
+  0xa0761d6478bd642fllu, 0xe7037ed1a0b428dbllu, 0x8ebc6af09c88c6e3llu, 0x589965cc75374cc3llu,
+};
+
+inline function u64
+str8_hash_mix(u64 a, u64 b)
+{
+  u64 hi;
+  u64 lo = MulU64ToU128(a, b, &hi);
+  return(lo ^ hi);
+}
+
+inline function u64
+str8_hash_read_u64(u8 *p)
+{
+  u64 result;
+  MemoryCopy(&result, p, sizeof(result));
+  return(result);
+}
+
+inline function u64
+str8_hash_read_u32(u8 *p)
+{
+  u32 result;
+  MemoryCopy(&result, p, sizeof(result));
+  return((u64)result);
+}
+
 function u64
 str8_calculate_hash(String_U8_Const str, u64 base)
 {
-  u64 result = base;
-  for (u64 idx = 0; idx < str.count; ++idx)
+  u8 *p = str.s;
+  u64 len = str.count;
+  u64 seed = base ^ str8_hash_mix(base ^ str8_hash_secret[0], str8_hash_secret[1]);
+  u64 a, b;
+  
+  if (len <= 16)
+  {
+    if (len >= 4)
+    {
+      u64 quarter = (len >> 3) << 2;
+      a = (str8_hash_read_u32(p) << 32) | str8_hash_read_u32(p + quarter);
+      b = (str8_hash_read_u32(p + len - 4) << 32) | str8_hash_read_u32(p + len - 4 - quarter);
+    }
+    else if (len > 0)
+    {
+      a = ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | (u64)p[len - 1];
+      b = 0;
+    }
+    else
+    {
+      a = b = 0;
+    }
+  }
+  else
   {
-    result = (result << 5) + (u64)str.s[idx];
+    u64 remaining = len;
+    if (remaining > 48)
+    {
+      u64 see1 = seed, see2 = seed;
+      do
+      {
+        seed = str8_hash_mix(str8_hash_read_u64(p) ^ str8_hash_secret[1], str8_hash_read_u64(p + 8) ^ seed);
+        see1 = str8_hash_mix(str8_hash_read_u64(p + 16) ^ str8_hash_secret[2], str8_hash_read_u64(p + 24) ^ see1);
+        see2 = str8_hash_mix(str8_hash_read_u64(p + 32) ^ str8_hash_secret[3], str8_hash_read_u64(p + 40) ^ see2);
+        p += 48;
+        remaining -= 48;
+      } while (remaining > 48);
+      seed ^= see1 ^ see2;
+    }
+    
+    while (remaining > 16)
+    {
+      seed = str8_hash_mix(str8_hash_read_u64(p) ^ str8_hash_secret[1], str8_hash_read_u64(p + 8) ^ seed);
+      p += 16;
+      remaining -= 16;
+    }
+    
+    a = str8_hash_read_u64(p + remaining - 16);
+    b = str8_hash_read_u64(p + remaining - 8);
   }
+  
+  a ^= str8_hash_secret[1];
+  b ^= seed;
+  u64 hi;
+  a = MulU64ToU128(a, b, &hi);
+  b = hi;
+  
+  u64 result = str8_hash_mix(a ^ str8_hash_secret[0] ^ len, b ^ str8_hash_secret[1]);
   return(result);
 }
 
@@ -193,47 +1380,109 @@ str8_equal_strings(String_U8_Const a, String_U8_Const b)
   {
     u64 N = a.count;
     u64 char_idx = 0;
-    while ((char_idx < N) && (a.s[char_idx] == b.s[char_idx]))
+    b32 mismatch = 0;
+
+#if defined(DR_SIMD_AVX2)
+    for (; !mismatch && ((char_idx + 32) <= N); char_idx += 32)
     {
-      ++char_idx;
+      __m256i a_chunk = _mm256_loadu_si256((__m256i *)(a.s + char_idx));
+      __m256i b_chunk = _mm256_loadu_si256((__m256i *)(b.s + char_idx));
+      mismatch = ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a_chunk, b_chunk)) != 0xFFFFFFFF);
+    }
+#endif
+
+#if defined(DR_SIMD_SSE2)
+    for (; !mismatch && ((char_idx + 16) <= N); char_idx += 16)
+    {
+      __m128i a_chunk = _mm_loadu_si128((__m128i *)(a.s + char_idx));
+      __m128i b_chunk = _mm_loadu_si128((__m128i *)(b.s + char_idx));
+      mismatch = (_mm_movemask_epi8(_mm_cmpeq_epi8(a_chunk, b_chunk)) != 0xFFFF);
+    }
+#endif
+
+    if (!mismatch)
+    {
+      while ((char_idx < N) && (a.s[char_idx] == b.s[char_idx]))
+      {
+        ++char_idx;
+      }
+      
+      result = (char_idx == N);
     }
-    
-    result = (char_idx == N);
   }
   
   return(result);
 }
 
+// NOTE(cj): candidate positions are the ones where both the first and the last
+// byte of to_find match. Testing both rejects almost everything before the full
+// compare, even for identifiers that all start with the same character.
 function u64
 str8_find_first_string(String_U8_Const str, String_U8_Const to_find, u64 offset_from_beginning_of_source)
 {
   u64 result = InvalidIndexU64;
   if (to_find.count && (str.count >= to_find.count))
   {
-    result = offset_from_beginning_of_source;
+    u64 at = offset_from_beginning_of_source;
     u8 first_char_of_to_find = to_find.s[0];
+    u8 last_char_of_to_find = to_find.s[to_find.count - 1];
+    u64 last_offset = to_find.count - 1;
     u64 one_past_last = str.count - to_find.count + 1;
-    
-    for (; result < one_past_last; ++result)
+
+#if defined(DR_SIMD_AVX2)
+    __m256i first_wide = _mm256_set1_epi8((char)first_char_of_to_find);
+    __m256i last_wide = _mm256_set1_epi8((char)last_char_of_to_find);
+    for (; (result == InvalidIndexU64) && ((at + 32) <= one_past_last); at += 32)
     {
-      if (str.s[result] == first_char_of_to_find)
+      __m256i first_block = _mm256_loadu_si256((__m256i *)(str.s + at));
+      __m256i last_block = _mm256_loadu_si256((__m256i *)(str.s + at + last_offset));
+      u32 candidates = (u32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first_block, first_wide),
+                                                                  _mm256_cmpeq_epi8(last_block, last_wide)));
+      for (; candidates; candidates &= candidates - 1)
       {
-        if (str.count >= (result + to_find.count))
+        u64 candidate = at + CountTrailingZerosU64(candidates);
+        if (!memcmp(str.s + candidate + 1, to_find.s + 1, last_offset))
         {
-          String_U8_Const substring;
-          substring.s = str.s + result;
-          substring.count = to_find.count;
-          if (str8_equal_strings(substring, to_find))
-          {
-            break;
-          }
+          result = candidate;
+          break;
         }
       }
     }
-    
-    if (result == one_past_last)
+#endif
+
+#if defined(DR_SIMD_SSE2)
+    __m128i first_narrow = _mm_set1_epi8((char)first_char_of_to_find);
+    __m128i last_narrow = _mm_set1_epi8((char)last_char_of_to_find);
+    for (; (result == InvalidIndexU64) && ((at + 16) <= one_past_last); at += 16)
+    {
+      __m128i first_block = _mm_loadu_si128((__m128i *)(str.s + at));
+      __m128i last_block = _mm_loadu_si128((__m128i *)(str.s + at + last_offset));
+      u32 candidates = (u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first_narrow),
+                                                            _mm_cmpeq_epi8(last_block, last_narrow)));
+      for (; candidates; candidates &= candidates - 1)
+      {
+        u64 candidate = at + CountTrailingZerosU64(candidates);
+        if (!memcmp(str.s + candidate + 1, to_find.s + 1, last_offset))
+        {
+          result = candidate;
+          break;
+        }
+      }
+    }
+#endif
+
+    for (; (result == InvalidIndexU64) && (at < one_past_last); ++at)
     {
-      result = InvalidIndexU64;
+      if ((str.s[at] == first_char_of_to_find) && (str.s[at + last_offset] == last_char_of_to_find))
+      {
+        String_U8_Const substring;
+        substring.s = str.s + at;
+        substring.count = to_find.count;
+        if (str8_equal_strings(substring, to_find))
+        {
+          result = at;
+        }
+      }
     }
   }
   
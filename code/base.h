@@ -3,8 +3,43 @@
 #ifndef BASE_H
 #define BASE_H
 
+// NOTE(cj): MAP_ANONYMOUS, MAP_NORESERVE, madvise and friends are not part of
+// strict C11/POSIX, glibc only declares them with this. It has to be defined
+// before the first system header.
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+# define _DEFAULT_SOURCE 1
+#endif
+
 #include <stdint.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <math.h>
+
+// NOTE(cj): SIMD paths are picked at build time from what the compiler targets
+// (/arch:AVX2, -mavx2, ...). x64 always has SSE2. Define DR_NO_SIMD to force the
+// scalar code.
+#if !defined(DR_NO_SIMD)
+# if defined(__AVX2__)
+#  define DR_SIMD_AVX2 1
+# endif
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  define DR_SIMD_SSE2 1
+# endif
+#endif
+
+#if defined(DR_SIMD_SSE2) || defined(DR_SIMD_AVX2)
+# include <immintrin.h>
+#endif
+
+#if defined(_WIN32)
+# define OS_WINDOWS 1
+#else
+# define OS_POSIX 1
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
 typedef uint8_t u8;
 typedef int8_t s8;
 typedef uint16_t u16;
@@ -20,10 +55,20 @@ typedef s32 b32;
 #define Stmnt(s) do{s}while(0)
 #define function static
 #define global_variable static
-#define thread_variable __declspec(thread)
+#if defined(_MSC_VER)
+# define thread_variable __declspec(thread)
+# define no_inline __declspec(noinline)
+#else
+# define thread_variable _Thread_local
+# define no_inline __attribute__((noinline))
+#endif
 
 #if defined(DR_DEBUG)
-# define AssertBreak() __debugbreak()
+# if defined(_MSC_VER)
+#  define AssertBreak() __debugbreak()
+# else
+#  define AssertBreak() __builtin_trap()
+# endif
 # define Assert(c) Stmnt( if(!(c)){AssertBreak();} )
 #else
 # define AssertBreak()
@@ -53,7 +98,7 @@ Assert(0);\
 #define KB(v) (1024llu*(u64)(v))
 #define MB(v) (1024llu*KB(v))
 #define GB(v) (1024llu*MB(v))
-#define AlignAToB(a,b) ((a)+((b)-1))&(~((b)-1))
+#define AlignAToB(a,b) (((a)+((b)-1))&(~((b)-1)))
 #define MemoryClear(m,sz) memset(m,'\0',sz)
 #define ClearStructP(s) MemoryClear(s,sizeof(*s))
 #define Swap(T,a,b) Stmnt(T temp = a; a = b; b = temp;)
@@ -63,40 +108,265 @@ Assert(0);\
 
 #define SLLPushFrontN(head,n,next) (((n)->next=(head)),(head)=(n))
 
+#if defined(_MSC_VER)
+# define AtomicIncEvalU64(p) ((u64)_InterlockedIncrement64((volatile __int64 *)(p)))
+# define CountTrailingZerosU64(v) count_trailing_zeros_u64(v)
+# define MulU64ToU128(a,b,hi) _umul128((a),(b),(hi))
+inline function u64
+count_trailing_zeros_u64(u64 v)
+{
+  unsigned long idx = 64;
+  if (v)
+  {
+    _BitScanForward64(&idx, v);
+  }
+  return((u64)idx);
+}
+#else
+# define AtomicIncEvalU64(p) __atomic_add_fetch((p), 1, __ATOMIC_SEQ_CST)
+# define CountTrailingZerosU64(v) ((v) ? (u64)__builtin_ctzll(v) : 64llu)
+# define MulU64ToU128(a,b,hi) mul_u64_to_u128((a),(b),(hi))
+inline function u64
+mul_u64_to_u128(u64 a, u64 b, u64 *hi)
+{
+  __uint128_t r = (__uint128_t)a * b;
+  *hi = (u64)(r >> 64);
+  return((u64)r);
+}
+#endif
+
+#define str8(s) (String_U8_Const){(u8*)(s),(sizeof(s)-1),(sizeof(s)-1)}
+typedef struct
+{
+  u8 *s;
+  u64 cap;
+  u64 count;
+} String_U8_Const;
+typedef String_U8_Const String_U8;
+
 #define M_Arena_DefaultCommit KB(128)
+#define M_Arena_LargePageSize MB(2)
+
+// NOTE(cj): decommit hysteresis a large page arena starts with when the OS would
+// not give us real large pages. Decommitting right away would return memory in
+// 2MB steps on every pop that crosses one.
+#if !defined(M_Arena_LargePageDecommitFrames)
+# define M_Arena_LargePageDecommitFrames 120
+#endif
+
+typedef u32 M_Arena_Flag;
+enum
+{
+  // NOTE(cj): back the arena with 2MB pages. Windows and Linux (MAP_HUGETLB)
+  // commit the whole reservation up front. If the OS refuses (no privilege, empty
+  // hugetlb pool), we fall back to a normal reservation that is 2MB aligned, committed
+  // in 2MB steps, and (on Linux) marked with MADV_HUGEPAGE for transparent huge pages.
+  // That fallback decommits with M_Arena_LargePageDecommitFrames of hysteresis.
+  M_ArenaFlag_LargePages = 0x1,
+  
+  // NOTE(cj): the pages are never given back to the OS on pop. Set automatically
+  // when the OS committed the entire reservation for us.
+  M_ArenaFlag_NoDecommit = 0x2,
+  
+  // NOTE(cj): instead of failing when the reservation is used up, reserve another
+  // block of the same size (or bigger, for a huge push) and keep going.
+  M_ArenaFlag_Chained = 0x4,
+};
+
 typedef struct
+{
+  u64 commit_count;
+  u64 decommit_count;
+  // NOTE(cj): first-touch faults. We can't observe these per arena, so this counts
+  // one per freshly committed page, which is what the OS will fault in.
+  u64 page_fault_count;
+  
+  // NOTE(cj): only counted with DR_ARENA_TELEMETRY, they would cost every push
+  u64 push_count;
+  u64 largest_push;
+  // NOTE(cj): the push path doesn't track this either. Every frame's peak gets
+  // here through frame_high_water_ptr at m_arena_end_frame, and
+  // m_arena_get_telemetry folds in the frame that is still going.
+  u64 peak_stack_ptr;
+} M_Arena_Stats;
+
+typedef struct M_Arena M_Arena;
+struct M_Arena
 {
   u8 *base;
   u64 commit_ptr;
   u64 stack_ptr;
   u64 capacity;
-} M_Arena;
+  u64 commit_granularity;
+  M_Arena_Flag flags;
+  
+  // NOTE(cj): decommit hysteresis. When decommit_after_frames is zero, pop gives
+  // the pages back right away. Otherwise pop only records the high-water mark and
+  // m_arena_end_frame decommits once the committed memory has sat more than
+  // decommit_slack bytes above the high-water mark for that many frames in a row.
+  u32 decommit_after_frames;
+  u32 frames_below_threshold;
+  u64 decommit_slack;
+  u64 frame_high_water_ptr;
+  u64 window_high_water_ptr;
+  
+  M_Arena_Stats stats;
+  
+  // NOTE(cj): set by m_arena_set_name. Not copied, so it must outlive the arena.
+  String_U8_Const name;
+  
+  // NOTE(cj): chaining. Pushes always go to `current`, which is the arena itself
+  // unless it is chained and has overflowed. Blocks link back through `prev`.
+  // base_pos is the position of a block's first byte, so positions
+  // (base_pos + stack_ptr) keep growing across blocks.
+  M_Arena *current;
+  M_Arena *prev;
+  M_Arena *spare;
+  u64 base_pos;
+  
+  // NOTE(cj): 1-based index into the owning thread's scratch pool, 0 otherwise
+  u32 scratch_slot;
+};
+#define M_Arena_HeaderSize AlignAToB(sizeof(M_Arena), 16)
 
 #define M_Arena_PushStruct(arena,T) M_Arena_PushArray((arena),T,1)
 #define M_Arena_PushArray(arena,T,count) (T*)m_arena_push(arena,sizeof(T)*(count))
 function M_Arena     *m_arena_reserve(u64 reserve_size);
+function M_Arena     *m_arena_reserve_flags(u64 reserve_size, M_Arena_Flag flags);
+function void         m_arena_release(M_Arena *arena);
 function void        *m_arena_push(M_Arena *arena, u64 push_size);
+function void        *m_arena_grow(M_Arena *arena, void *data, u64 old_size, u64 new_size);
 function void         m_arena_pop(M_Arena *arena, u64 pop_size);
+function void         m_arena_pop_to(M_Arena *arena, u64 pos);
+inline function u64   m_arena_pos(M_Arena *arena);
 inline function void  m_arena_clear(M_Arena *arena);
+function void         m_arena_set_decommit_hysteresis(M_Arena *arena, u32 frames, u64 slack);
+function void         m_arena_end_frame(M_Arena *arena);
+
+//
+// NOTE(cj): Arena telemetry. Named arenas are kept in a global registry so the
+// usage of every arena can be read back (or dumped once per frame) without
+// having to know who owns it.
+//
+#define M_Arena_MaxRegistered 64
+typedef struct
+{
+  String_U8_Const name;
+  u64 current_bytes;
+  u64 peak_bytes;
+  u64 committed_bytes;
+  u64 reserved_bytes;
+  u64 push_count;
+  u64 largest_push;
+} M_Arena_Telemetry;
+
+// NOTE(cj): the binary dump is a stream of these, one per registered arena per frame.
+typedef struct
+{
+  u64 frame_index;
+  u8 name[32];
+  u64 current_bytes;
+  u64 peak_bytes;
+  u64 committed_bytes;
+  u64 reserved_bytes;
+  u64 push_count;
+  u64 largest_push;
+} M_Arena_TelemetryRecord;
+
+function void              m_arena_set_name(M_Arena *arena, String_U8_Const name);
+function M_Arena_Telemetry m_arena_get_telemetry(M_Arena *arena);
+function u64               m_arena_registered_count(void);
+function M_Arena          *m_arena_registered(u64 index);
+function b32               m_arena_telemetry_open_dump(char *path, b32 binary);
+function void              m_arena_telemetry_dump_frame(u64 frame_index);
+function void              m_arena_telemetry_close_dump(void);
 
 typedef struct
 {
   M_Arena *arena;
-  u64 start_stack_ptr;
+  u64 start_pos;
 } Temporary_Memory;
 inline function Temporary_Memory begin_temporary_memory(M_Arena *arena);
 inline function void end_temporary_memory(Temporary_Memory temp);
 
-function M_Arena *get_transient_arena(M_Arena **conflict, u64 count);
+// NOTE(cj): per-thread scratch memory. Pass the arenas you are already using (e.g.
+// the one the caller wants the result in) as conflicts, and you get a scratch arena
+// that is none of them. ScratchScope pops it again when the block is left normally.
+#define Scratch_MaxArenas 8
+#define Scratch_ArenaSize MB(8)
+typedef struct
+{
+  M_Arena *arenas[Scratch_MaxArenas];
+} Scratch_Pool;
+
+function M_Arena         *scratch_get_arena(M_Arena **conflicts, u64 count);
+function Temporary_Memory scratch_begin(M_Arena **conflicts, u64 count);
+// NOTE(cj): m_arena_end_frame for every scratch arena of the calling thread
+function void             scratch_end_frame(void);
+#define scratch_end(temp) end_temporary_memory(temp)
+#define ScratchScope(name,conflicts,count) \
+for (Temporary_Memory name = scratch_begin((conflicts),(count)); name.arena; scratch_end(name), name.arena = 0)
+
+//
+// NOTE(cj): Fixed-size pool on top of an arena. Slots are carved out of chunks of
+// slots_per_chunk elements and recycled through an intrusive free list that lives
+// in each slot's header, right before the element. The generation is odd while the
+// slot is alive and even while it is free, so a handle to a freed (or reused) slot
+// is detected on lookup. Freed elements are NOT cleared.
+//
+typedef struct M_Pool_Slot M_Pool_Slot;
+struct M_Pool_Slot
+{
+  M_Pool_Slot *next_free;
+  u32 generation;
+  u32 index;
+};
+#define M_Pool_SlotHeaderSize AlignAToB(sizeof(M_Pool_Slot), 16)
 
-#define str8(s) (String_U8_Const){(u8*)(s),(sizeof(s)-1),(sizeof(s)-1)}
 typedef struct
 {
-  u8 *s;
-  u64 cap;
-  u64 count;
-} String_U8_Const;
-typedef String_U8_Const String_U8;
+  u32 index;
+  u32 generation;
+} M_Pool_Handle;
+
+typedef struct
+{
+  M_Arena *arena;
+  u64 slot_stride;
+  u64 slots_per_chunk;
+  
+  u8 **chunks;
+  u64 chunk_count;
+  u64 chunk_capacity;
+  // NOTE(cj): slots of the newest chunk that were never handed out
+  u64 next_unused_in_chunk;
+  
+  M_Pool_Slot *free_list;
+  u64 live_count;
+} M_Pool;
+
+function void          m_pool_init(M_Pool *pool, M_Arena *arena, u64 element_size, u64 slots_per_chunk);
+function void         *m_pool_alloc(M_Pool *pool);
+function void          m_pool_free(M_Pool *pool, void *element);
+function void          m_pool_free_many(M_Pool *pool, void **elements, u64 count);
+function void          m_pool_reset(M_Pool *pool);
+function M_Pool_Handle m_pool_handle(M_Pool *pool, void *element);
+function void         *m_pool_get(M_Pool *pool, M_Pool_Handle handle);
+
+#define M_DefinePoolFN(T,name) \
+inline function T *name##_pool_alloc(M_Pool *pool) \
+{\
+Assert(pool->slot_stride >= sizeof(T));\
+return (T *)m_pool_alloc(pool);\
+}\
+inline function void name##_pool_free(M_Pool *pool, T *element) \
+{\
+m_pool_free(pool, element);\
+}\
+inline function T *name##_pool_get(M_Pool *pool, M_Pool_Handle handle) \
+{\
+return (T *)m_pool_get(pool, handle);\
+}
 
 function String_U8_Const str8_format_va(M_Arena *arena, String_U8_Const str, va_list args0);
 function String_U8_Const str8_format(M_Arena *arena, String_U8_Const string, ...);
@@ -4,6 +4,11 @@ setlocal enabledelayedexpansion
 if not exist ..\build mkdir ..\build
 pushd ..\build
 cl /wd4201 /Zi /Od /nologo /W4 /DDR_DEBUG ..\code\main.c /link /incremental:no user32.lib gdi32.lib d3d11.lib dxgi.lib dxguid.lib d3dcompiler.lib winmm.lib
+cl /wd4201 /Zi /O2 /nologo /W4 /DDR_DEBUG ..\code\tests.c /Fe:tests.exe /link /incremental:no
+REM NOTE(cj): the same tests with /arch:AVX2, which is the only way the avx2 paths get built
+cl /wd4201 /Zi /O2 /nologo /W4 /arch:AVX2 /DDR_DEBUG ..\code\tests.c /Fe:tests_avx2.exe /Fo:tests_avx2.obj /Fd:tests_avx2.pdb /link /incremental:no
+REM NOTE(cj): the game without a window or renderer, headless.exe prints the wave report (headless crowd, the crowd report)
+cl /wd4201 /Zi /O2 /nologo /W4 /arch:AVX2 /DDR_DEBUG /DDR_HEADLESS ..\code\main.c /Fe:headless.exe /Fo:headless.obj /Fd:headless.pdb /link /incremental:no
 popd
 
 endlocal
\ No newline at end of file
@@ -0,0 +1,18 @@
+#!/bin/sh
+# NOTE(cj): The game itself is windows only, this builds the tests for the
+# platform independent code. Run ../build/tests, or ../build/tests bench.
+# tests_avx2 is the same program built with -mavx2, for the avx2 paths.
+# headless is the game without a window, ../build/headless prints the wave
+# report and ../build/headless crowd the crowd report (see the bottom of main.c).
+set -e
+
+# NOTE(cj): like /wd4201 in build.bat. The vector and frame literals lean on
+# brace elision through the unions ((v4f){ 1, 0, 0, 1 }), and frames leave
+# offset out on purpose, so these two only ever warn about the repo's idiom.
+warnings="-Wall -Wextra -Wno-unused-function -Wno-missing-braces -Wno-missing-field-initializers"
+
+mkdir -p ../build
+cd ../build
+cc -std=c11 -O2 -g $warnings -DDR_DEBUG ../code/tests.c -o tests -lm -lpthread
+cc -std=c11 -O2 -g $warnings -mavx2 -DDR_DEBUG ../code/tests.c -o tests_avx2 -lm -lpthread
+cc -std=c11 -O2 -g $warnings -mavx2 -DDR_DEBUG -DDR_HEADLESS ../code/main.c -o headless -lm
@@ -0,0 +1,282 @@
+function void *
+dr_array_grow(M_Arena *arena, void *data, u64 element_size, u64 old_capacity, u64 new_capacity)
+{
+  void *result = m_arena_grow(arena, data, old_capacity * element_size, new_capacity * element_size);
+  return(result);
+}
+
+// NOTE(cj): murmur3's finalizer. Keys are often small sequential integers or
+// already-hashed values, so the low bits need to be mixed either way.
+inline function u64
+hash_u64(u64 key)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdllu;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53llu;
+  key ^= key >> 33;
+  return(key);
+}
+
+inline function u8
+hash_map_h2(u64 hash)
+{
+  u8 result = (u8)(hash & 0x7F);
+  return(result);
+}
+
+// NOTE(cj): returns a bitmask of the control bytes in the group equal to `byte`
+inline function u32
+hash_map_group_match(u8 *group, u8 byte)
+{
+#if defined(DR_SIMD_SSE2)
+  __m128i ctrl = _mm_loadu_si128((__m128i *)group);
+  __m128i cmp = _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte));
+  u32 result = (u32)_mm_movemask_epi8(cmp);
+#else
+  u32 result = 0;
+  for (u32 idx = 0; idx < HashMap_GroupWidth; ++idx)
+  {
+    result |= (u32)(group[idx] == byte) << idx;
+  }
+#endif
+  return(result);
+}
+
+inline function void
+hash_map_set_ctrl(HashMap_U64 *map, u64 slot, u8 ctrl)
+{
+  map->ctrl[slot] = ctrl;
+  // NOTE(cj): keep the mirrored tail in sync so a group load at the end of the
+  // table wraps around
+  if (slot < HashMap_GroupWidth)
+  {
+    map->ctrl[map->capacity + slot] = ctrl;
+  }
+}
+
+function void
+hash_map_u64_alloc(HashMap_U64 *map, u64 capacity)
+{
+  map->capacity = capacity;
+  map->ctrl = M_Arena_PushArray(map->arena, u8, capacity + HashMap_GroupWidth);
+  map->keys = M_Arena_PushArray(map->arena, u64, capacity);
+  map->values = M_Arena_PushArray(map->arena, u8, capacity * map->value_size);
+  memset(map->ctrl, HashMap_CtrlEmpty, capacity + HashMap_GroupWidth);
+  map->count = 0;
+  map->tombstones = 0;
+}
+
+function void
+hash_map_u64_init(HashMap_U64 *map, M_Arena *arena, u64 value_size, u64 initial_capacity)
+{
+  u64 capacity = HashMap_GroupWidth;
+  while (capacity < initial_capacity)
+  {
+    capacity *= 2;
+  }
+  
+  map->arena = arena;
+  map->value_size = value_size;
+  hash_map_u64_alloc(map, capacity);
+}
+
+// NOTE(cj): probe group by group (triangular steps, which visit every group when
+// the group count is a power of two). Returns the slot holding the key, or
+// InvalidIndexU64. If `insert_slot` is given, it receives the first empty or
+// deleted slot seen along the way.
+function u64
+hash_map_u64_probe(HashMap_U64 *map, u64 key, u64 *insert_slot)
+{
+  u64 hash = hash_u64(key);
+  u8 h2 = hash_map_h2(hash);
+  u64 mask = map->capacity - 1;
+  u64 pos = (hash >> 7) & mask;
+  u64 result = InvalidIndexU64;
+  u64 first_free = InvalidIndexU64;
+  
+  for (u64 stride = 0; stride <= map->capacity; stride += HashMap_GroupWidth)
+  {
+    u8 *group = map->ctrl + pos;
+    for (u32 matches = hash_map_group_match(group, h2); matches; matches &= matches - 1)
+    {
+      u64 slot = (pos + CountTrailingZerosU64(matches)) & mask;
+      if (map->keys[slot] == key)
+      {
+        result = slot;
+        break;
+      }
+    }
+    
+    if (result != InvalidIndexU64)
+    {
+      break;
+    }
+    
+    u32 empties = hash_map_group_match(group, HashMap_CtrlEmpty);
+    if (first_free == InvalidIndexU64)
+    {
+      u32 frees = empties | hash_map_group_match(group, HashMap_CtrlDeleted);
+      if (frees)
+      {
+        first_free = (pos + CountTrailingZerosU64(frees)) & mask;
+      }
+    }
+    
+    if (empties)
+    {
+      break;
+    }
+    
+    pos = (pos + stride + HashMap_GroupWidth) & mask;
+  }
+  
+  if (insert_slot)
+  {
+    *insert_slot = first_free;
+  }
+  
+  return(result);
+}
+
+function void *
+hash_map_u64_find(HashMap_U64 *map, u64 key)
+{
+  void *result = 0;
+  u64 slot = hash_map_u64_probe(map, key, 0);
+  if (slot != InvalidIndexU64)
+  {
+    result = map->values + slot * map->value_size;
+  }
+  return(result);
+}
+
+function void
+hash_map_u64_rehash(HashMap_U64 *map, u64 new_capacity)
+{
+  if (new_capacity == map->capacity)
+  {
+    // NOTE(cj): only clearing out tombstones. The live entries go to scratch and
+    // back into the same table, so a map that churns at a steady size (the UI's
+    // identifiers) doesn't leave a dead table in its arena every time.
+    Temporary_Memory scratch = scratch_begin(&map->arena, 1);
+    u64 live_count = 0;
+    u64 *keys = M_Arena_PushArray(scratch.arena, u64, map->count);
+    u8 *values = M_Arena_PushArray(scratch.arena, u8, map->count * map->value_size);
+    for (u64 slot = 0; slot < map->capacity; ++slot)
+    {
+      if (!(map->ctrl[slot] & 0x80))
+      {
+        keys[live_count] = map->keys[slot];
+        MemoryCopy(values + live_count * map->value_size, map->values + slot * map->value_size, map->value_size);
+        live_count += 1;
+      }
+    }
+    
+    hash_map_u64_clear(map);
+    for (u64 idx = 0; idx < live_count; ++idx)
+    {
+      void *value = hash_map_u64_insert(map, keys[idx], 0);
+      MemoryCopy(value, values + idx * map->value_size, map->value_size);
+    }
+    scratch_end(scratch);
+  }
+  else
+  {
+    // NOTE(cj): growing. The old table stays behind in the arena, which only
+    // happens log2(peak size) times.
+    HashMap_U64 old = *map;
+    hash_map_u64_alloc(map, new_capacity);
+    for (u64 slot = 0; slot < old.capacity; ++slot)
+    {
+      if (!(old.ctrl[slot] & 0x80))
+      {
+        void *value = hash_map_u64_insert(map, old.keys[slot], 0);
+        MemoryCopy(value, old.values + slot * old.value_size, old.value_size);
+      }
+    }
+  }
+}
+
+function void *
+hash_map_u64_insert(HashMap_U64 *map, u64 key, b32 *was_present)
+{
+  // NOTE(cj): keep the load (live + tombstones) under 7/8
+  if ((map->count + map->tombstones + 1) * 8 > map->capacity * 7)
+  {
+    u64 new_capacity = ((map->count + 1) * 8 > map->capacity * 4) ? (map->capacity * 2) : map->capacity;
+    hash_map_u64_rehash(map, new_capacity);
+  }
+  
+  u64 insert_slot;
+  u64 slot = hash_map_u64_probe(map, key, &insert_slot);
+  b32 present = (slot != InvalidIndexU64);
+  if (!present)
+  {
+    Assert(insert_slot != InvalidIndexU64);
+    slot = insert_slot;
+    if (map->ctrl[slot] == HashMap_CtrlDeleted)
+    {
+      map->tombstones -= 1;
+    }
+    hash_map_set_ctrl(map, slot, hash_map_h2(hash_u64(key)));
+    map->keys[slot] = key;
+    map->count += 1;
+  }
+  
+  if (was_present)
+  {
+    *was_present = present;
+  }
+  
+  void *result = map->values + slot * map->value_size;
+  return(result);
+}
+
+function b32
+hash_map_u64_remove(HashMap_U64 *map, u64 key)
+{
+  u64 slot = hash_map_u64_probe(map, key, 0);
+  b32 result = (slot != InvalidIndexU64);
+  if (result)
+  {
+    hash_map_set_ctrl(map, slot, HashMap_CtrlDeleted);
+    map->count -= 1;
+    map->tombstones += 1;
+  }
+  return(result);
+}
+
+function void
+hash_map_u64_clear(HashMap_U64 *map)
+{
+  memset(map->ctrl, HashMap_CtrlEmpty, map->capacity + HashMap_GroupWidth);
+  map->count = 0;
+  map->tombstones = 0;
+}
+
+function void *
+hash_map_u64_next(HashMap_U64 *map, u64 *cursor, u64 *key)
+{
+  void *result = 0;
+  for (u64 slot = *cursor; slot < map->capacity; ++slot)
+  {
+    if (!(map->ctrl[slot] & 0x80))
+    {
+      if (key)
+      {
+        *key = map->keys[slot];
+      }
+      result = map->values + slot * map->value_size;
+      *cursor = slot + 1;
+      break;
+    }
+  }
+  
+  if (!result)
+  {
+    *cursor = map->capacity;
+  }
+  
+  return(result);
+}
@@ -0,0 +1,105 @@
+/* date = October 17th 2026 9:12 am */
+
+#ifndef CONTAINERS_H
+#define CONTAINERS_H
+
+//
+// NOTE(cj): Growable array that lives in an arena. When the array is the last
+// thing pushed on the arena it grows in place, otherwise it moves to a block
+// twice the size and the old storage is left behind in the arena.
+//
+function void *dr_array_grow(M_Arena *arena, void *data, u64 element_size, u64 old_capacity, u64 new_capacity);
+
+#define DefineDynamicArray(T,name) \
+typedef struct \
+{\
+M_Arena *arena;\
+T *v;\
+u64 count;\
+u64 capacity;\
+} T##_Array;\
+inline function void name##_array_init(T##_Array *arr, M_Arena *arena, u64 initial_capacity) \
+{\
+arr->arena = arena;\
+arr->count = 0;\
+arr->capacity = Max(initial_capacity, 4);\
+arr->v = M_Arena_PushArray(arena, T, arr->capacity);\
+}\
+inline function void name##_array_reserve(T##_Array *arr, u64 capacity) \
+{\
+if (capacity > arr->capacity)\
+{\
+u64 new_capacity = Max(arr->capacity * 2, capacity);\
+arr->v = (T *)dr_array_grow(arr->arena, arr->v, sizeof(T), arr->capacity, new_capacity);\
+arr->capacity = new_capacity;\
+}\
+}\
+inline function T *name##_array_push(T##_Array *arr) \
+{\
+if (arr->count == arr->capacity)\
+{\
+name##_array_reserve(arr, arr->count + 1);\
+}\
+return (arr->v + arr->count++);\
+}\
+inline function void name##_array_swap_remove(T##_Array *arr, u64 idx) \
+{\
+Assert(idx < arr->count);\
+arr->v[idx] = arr->v[--arr->count];\
+}
+
+//
+// NOTE(cj): Open-addressing hash map with u64 keys (swiss table layout).
+// Each slot has a control byte: Empty, Deleted, or the low 7 bits of the hash.
+// Probing loads 16 control bytes at a time and compares them all at once (SSE2),
+// so most lookups touch one group of control bytes and one key.
+// Values are stored out of line, value_size bytes each.
+//
+#define HashMap_GroupWidth 16
+#define HashMap_CtrlEmpty 0x80
+#define HashMap_CtrlDeleted 0xFE
+
+typedef struct
+{
+  M_Arena *arena;
+  u8 *ctrl;     // capacity + HashMap_GroupWidth bytes, the tail mirrors the head
+  u64 *keys;
+  u8 *values;
+  u64 value_size;
+  u64 capacity; // power of two
+  u64 count;
+  u64 tombstones;
+} HashMap_U64;
+
+inline function u64 hash_u64(u64 key);
+function void  hash_map_u64_init(HashMap_U64 *map, M_Arena *arena, u64 value_size, u64 initial_capacity);
+function void *hash_map_u64_find(HashMap_U64 *map, u64 key);
+function void *hash_map_u64_insert(HashMap_U64 *map, u64 key, b32 *was_present);
+function b32   hash_map_u64_remove(HashMap_U64 *map, u64 key);
+function void  hash_map_u64_clear(HashMap_U64 *map);
+// NOTE(cj): iteration. Start with *cursor = 0. Returns 0 when done.
+function void *hash_map_u64_next(HashMap_U64 *map, u64 *cursor, u64 *key);
+
+#define DefineHashMapU64(T,name) \
+inline function void name##_map_init(HashMap_U64 *map, M_Arena *arena, u64 initial_capacity) \
+{\
+hash_map_u64_init(map, arena, sizeof(T), initial_capacity);\
+}\
+inline function T *name##_map_find(HashMap_U64 *map, u64 key) \
+{\
+Assert(map->value_size == sizeof(T));\
+return (T *)hash_map_u64_find(map, key);\
+}\
+inline function T *name##_map_insert(HashMap_U64 *map, u64 key, T value) \
+{\
+Assert(map->value_size == sizeof(T));\
+T *result = (T *)hash_map_u64_insert(map, key, 0);\
+*result = value;\
+return(result);\
+}\
+inline function b32 name##_map_remove(HashMap_U64 *map, u64 key) \
+{\
+return hash_map_u64_remove(map, key);\
+}
+
+#endif //CONTAINERS_H
@@ -0,0 +1,170 @@
+function void
+entity_table_reserve(Entity_Table *table, u64 capacity)
+{
+  if (capacity > table->capacity)
+  {
+    Assert(capacity <= EntityHandle_MaxSlots);
+    u64 new_capacity = Min(Max(table->capacity * 2, capacity), EntityHandle_MaxSlots);
+
+#define EntityTable_GrowColumn(column) table->column = dr_array_grow(table->arena, table->column, sizeof(*table->column), table->capacity, new_capacity)
+    EntityTable_GrowColumn(handle);
+    EntityTable_GrowColumn(type);
+    EntityTable_GrowColumn(flags);
+    EntityTable_GrowColumn(x);
+    EntityTable_GrowColumn(y);
+    EntityTable_GrowColumn(prev_x);
+    EntityTable_GrowColumn(prev_y);
+    EntityTable_GrowColumn(half_dim_x);
+    EntityTable_GrowColumn(half_dim_y);
+    EntityTable_GrowColumn(current_hp);
+    EntityTable_GrowColumn(max_hp);
+    EntityTable_GrowColumn(last_face_dir);
+    EntityTable_GrowColumn(enemy);
+#undef EntityTable_GrowColumn
+
+    table->capacity = new_capacity;
+  }
+}
+
+function void
+entity_table_reserve_slots(Entity_Table *table, u64 slot_capacity)
+{
+  if (slot_capacity > table->slot_capacity)
+  {
+    Assert(slot_capacity <= EntityHandle_MaxSlots);
+    u64 new_capacity = Min(Max((u64)table->slot_capacity * 2, slot_capacity), EntityHandle_MaxSlots);
+    table->slot_dense_idx = dr_array_grow(table->arena, table->slot_dense_idx, sizeof(u32), table->slot_capacity, new_capacity);
+    table->slot_generation = dr_array_grow(table->arena, table->slot_generation, sizeof(u16), table->slot_capacity, new_capacity);
+    table->slot_capacity = (u32)new_capacity;
+  }
+}
+
+function void
+entity_table_init(Entity_Table *table, M_Arena *arena, u64 initial_capacity)
+{
+  ClearStructP(table);
+  table->arena = arena;
+  table->first_free_slot = EntityHandle_NilSlot;
+  entity_table_reserve(table, initial_capacity);
+  entity_table_reserve_slots(table, initial_capacity);
+}
+
+inline function u64
+entity_index_from_handle(const Entity_Table *table, Entity_Handle handle)
+{
+  u64 result = InvalidIndexU64;
+  u32 slot = handle & EntityHandle_SlotMask;
+  if (slot < table->slot_count)
+  {
+    u32 dense_idx = table->slot_dense_idx[slot];
+    if ((dense_idx < table->count) && (table->handle[dense_idx] == handle))
+    {
+      result = dense_idx;
+    }
+  }
+  return(result);
+}
+
+inline function v3f
+entity_p(const Entity_Table *table, u64 idx)
+{
+  v3f result = { table->x[idx], table->y[idx], 0.0f };
+  return(result);
+}
+
+inline function v3f
+entity_prev_p(const Entity_Table *table, u64 idx)
+{
+  v3f result = { table->prev_x[idx], table->prev_y[idx], 0.0f };
+  return(result);
+}
+
+inline function v3f
+entity_dims(const Entity_Table *table, u64 idx)
+{
+  v3f result = { table->half_dim_x[idx]*2.0f, table->half_dim_y[idx]*2.0f, 0.0f };
+  return(result);
+}
+
+inline function v2f
+entity_half_dims(const Entity_Table *table, u64 idx)
+{
+  v2f result = { table->half_dim_x[idx], table->half_dim_y[idx] };
+  return(result);
+}
+
+inline function void
+entity_set_p(Entity_Table *table, u64 idx, v3f p)
+{
+  table->x[idx] = p.x;
+  table->y[idx] = p.y;
+}
+
+inline function u64
+make_entity(Entity_Table *table, Entity_Type type, Entity_Flag flags)
+{
+  entity_table_reserve(table, table->count + 1);
+  u64 result = table->count++;
+  
+  u32 slot;
+  if (table->first_free_slot != EntityHandle_NilSlot)
+  {
+    slot = table->first_free_slot;
+    table->first_free_slot = table->slot_dense_idx[slot];
+  }
+  else
+  {
+    entity_table_reserve_slots(table, (u64)table->slot_count + 1);
+    slot = table->slot_count++;
+    table->slot_generation[slot] = 1;
+  }
+  table->slot_dense_idx[slot] = (u32)result;
+  table->handle[result] = ((u32)table->slot_generation[slot] << EntityHandle_SlotBits) | slot;
+  
+  table->type[result] = type;
+  table->flags[result] = flags;
+  table->x[result] = table->y[result] = 0.0f;
+  table->prev_x[result] = table->prev_y[result] = 0.0f;
+  table->half_dim_x[result] = table->half_dim_y[result] = 0.0f;
+  table->current_hp[result] = table->max_hp[result] = 0.0f;
+  table->last_face_dir[result] = 0;
+  ClearStructP(&table->enemy[result]);
+  return(result);
+}
+
+// NOTE(cj): moves the last entity into idx, and retires idx's handle
+function void
+entity_swap_remove(Entity_Table *table, u64 idx)
+{
+  Assert(idx < table->count);
+  u32 slot = table->handle[idx] & EntityHandle_SlotMask;
+  if (table->slot_generation[slot] < EntityHandle_MaxGeneration)
+  {
+    table->slot_generation[slot] += 1;
+    table->slot_dense_idx[slot] = table->first_free_slot;
+    table->first_free_slot = slot;
+  }
+  else
+  {
+    table->slot_dense_idx[slot] = EntityHandle_NilSlot;
+  }
+  
+  u64 last = --table->count;
+  if (idx != last)
+  {
+    table->handle[idx] = table->handle[last];
+    table->slot_dense_idx[table->handle[idx] & EntityHandle_SlotMask] = (u32)idx;
+  }
+  table->type[idx] = table->type[last];
+  table->flags[idx] = table->flags[last];
+  table->x[idx] = table->x[last];
+  table->y[idx] = table->y[last];
+  table->prev_x[idx] = table->prev_x[last];
+  table->prev_y[idx] = table->prev_y[last];
+  table->half_dim_x[idx] = table->half_dim_x[last];
+  table->half_dim_y[idx] = table->half_dim_y[last];
+  table->current_hp[idx] = table->current_hp[last];
+  table->max_hp[idx] = table->max_hp[last];
+  table->last_face_dir[idx] = table->last_face_dir[last];
+  table->enemy[idx] = table->enemy[last];
+}
@@ -0,0 +1,287 @@
+function void
+experience_gem_table_reserve(Experience_Gem_Table *table, u64 capacity)
+{
+  if (capacity > table->capacity)
+  {
+    u64 new_capacity = Max(table->capacity * 2, capacity);
+
+#define GemTable_GrowColumn(column) table->column = dr_array_grow(table->arena, table->column, sizeof(*table->column), table->capacity, new_capacity)
+    GemTable_GrowColumn(x);
+    GemTable_GrowColumn(y);
+    GemTable_GrowColumn(z);
+    GemTable_GrowColumn(prev_x);
+    GemTable_GrowColumn(prev_y);
+    GemTable_GrowColumn(dP_x);
+    GemTable_GrowColumn(dP_y);
+    GemTable_GrowColumn(dP_z);
+    GemTable_GrowColumn(t_countdown);
+    GemTable_GrowColumn(countdown_secs_before_dead);
+    GemTable_GrowColumn(value);
+    GemTable_GrowColumn(landed);
+    GemTable_GrowColumn(removals);
+#undef GemTable_GrowColumn
+
+    table->capacity = new_capacity;
+  }
+}
+
+function void
+experience_gem_table_init(Experience_Gem_Table *table, M_Arena *arena, u64 initial_capacity)
+{
+  ClearStructP(table);
+  table->arena = arena;
+  experience_gem_table_reserve(table, initial_capacity);
+}
+
+function void
+experience_gem_swap_remove(Experience_Gem_Table *table, u64 idx)
+{
+  Assert(idx < table->count);
+  u64 last = --table->count;
+  table->x[idx] = table->x[last];
+  table->y[idx] = table->y[last];
+  table->z[idx] = table->z[last];
+  table->prev_x[idx] = table->prev_x[last];
+  table->prev_y[idx] = table->prev_y[last];
+  table->dP_x[idx] = table->dP_x[last];
+  table->dP_y[idx] = table->dP_y[last];
+  table->dP_z[idx] = table->dP_z[last];
+  table->t_countdown[idx] = table->t_countdown[last];
+  table->countdown_secs_before_dead[idx] = table->countdown_secs_before_dead[last];
+  table->value[idx] = table->value[last];
+}
+
+// NOTE(cj): moves every gem that is still in the air one step along its arc, and
+// puts the ones that landed in table->landed. Returns how many landed.
+// Same math, in the same order, as stepping a single gem:
+//   p.x += dP.x*dt
+//   p.y += 0.5*g*dt*dt + dP.y*dt + dP.z*dt
+//   p.z += dP.z*dt
+//   dP.y += g*dt
+// TODO(cj): For now, we add the Z because we havent take into account the "depth" yet!
+function u64
+experience_gems_integrate(Experience_Gem_Table *table, f32 dt)
+{
+  u64 result = 0;
+  f32 g = -ExperienceGem_G;
+  f32 half_g_dt_dt = 0.5f*g*dt*dt;
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane zero = F32Lane_Set1(0.0f);
+  F32Lane dt_lane = F32Lane_Set1(dt);
+  F32Lane g_dt = F32Lane_Set1(g*dt);
+  F32Lane half_g_dt_dt_lane = F32Lane_Set1(half_g_dt_dt);
+  for (; (idx + F32Lane_Width) <= table->count; idx += F32Lane_Width)
+  {
+    F32Lane t_countdown = F32Lane_Load(table->t_countdown + idx);
+    F32Lane in_air = F32Lane_GreaterThan(t_countdown, zero);
+    if (F32Lane_MoveMask(in_air))
+    {
+      F32Lane x = F32Lane_Load(table->x + idx);
+      F32Lane y = F32Lane_Load(table->y + idx);
+      F32Lane z = F32Lane_Load(table->z + idx);
+      F32Lane dP_x = F32Lane_Load(table->dP_x + idx);
+      F32Lane dP_y = F32Lane_Load(table->dP_y + idx);
+      F32Lane dP_z = F32Lane_Load(table->dP_z + idx);
+      
+      F32Lane new_x = F32Lane_Add(x, F32Lane_Mul(dP_x, dt_lane));
+      F32Lane new_y = F32Lane_Add(y, F32Lane_Add(F32Lane_Add(half_g_dt_dt_lane, F32Lane_Mul(dP_y, dt_lane)), F32Lane_Mul(dP_z, dt_lane)));
+      F32Lane new_z = F32Lane_Add(z, F32Lane_Mul(dP_z, dt_lane));
+      F32Lane new_dP_y = F32Lane_Add(dP_y, g_dt);
+      
+      F32Lane_Store(table->x + idx, F32Lane_Select(in_air, new_x, x));
+      F32Lane_Store(table->y + idx, F32Lane_Select(in_air, new_y, y));
+      F32Lane_Store(table->z + idx, F32Lane_Select(in_air, new_z, z));
+      F32Lane_Store(table->dP_y + idx, F32Lane_Select(in_air, new_dP_y, dP_y));
+      
+      F32Lane new_t_countdown = F32Lane_Sub(t_countdown, dt_lane);
+      F32Lane_Store(table->t_countdown + idx, F32Lane_Select(in_air, new_t_countdown, t_countdown));
+      for (u32 landed_mask = F32Lane_MoveMask(F32Lane_And(in_air, F32Lane_LessOrEqual(new_t_countdown, zero))); landed_mask; landed_mask &= landed_mask - 1)
+      {
+        table->landed[result++] = (u32)(idx + CountTrailingZerosU64(landed_mask));
+      }
+    }
+  }
+#endif
+  for (; idx < table->count; ++idx)
+  {
+    if (table->t_countdown[idx] > 0)
+    {
+      table->x[idx] += table->dP_x[idx] * dt;
+      table->y[idx] += half_g_dt_dt + table->dP_y[idx]*dt + table->dP_z[idx]*dt;
+      table->z[idx] += table->dP_z[idx] * dt;
+      table->dP_y[idx] += g*dt;
+      table->t_countdown[idx] -= dt;
+      if (table->t_countdown[idx] <= 0)
+      {
+        table->landed[result++] = (u32)idx;
+      }
+    }
+  }
+  return(result);
+}
+
+// NOTE(cj): puts the gems the player touches, and the ones whose time is up, in
+// table->removals in ascending order. Returns how many there are.
+function u64
+experience_gems_collect_removals(Experience_Gem_Table *table, v2f player_p, v2f player_half_dims)
+{
+  u64 result = 0;
+  f32 reach_x = ExperienceGem_Dim*0.5f + player_half_dims.x;
+  f32 reach_y = ExperienceGem_Dim*0.5f + player_half_dims.y;
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane zero = F32Lane_Set1(0.0f);
+  F32Lane sign_bit = F32Lane_Set1(-0.0f);
+  F32Lane player_x = F32Lane_Set1(player_p.x);
+  F32Lane player_y = F32Lane_Set1(player_p.y);
+  F32Lane reach_x_lane = F32Lane_Set1(reach_x);
+  F32Lane reach_y_lane = F32Lane_Set1(reach_y);
+  for (; (idx + F32Lane_Width) <= table->count; idx += F32Lane_Width)
+  {
+    F32Lane dx = F32Lane_AndNot(sign_bit, F32Lane_Sub(F32Lane_Load(table->x + idx), player_x));
+    F32Lane dy = F32Lane_AndNot(sign_bit, F32Lane_Sub(F32Lane_Load(table->y + idx), player_y));
+    F32Lane touched = F32Lane_And(F32Lane_LessOrEqual(dx, reach_x_lane), F32Lane_LessOrEqual(dy, reach_y_lane));
+    F32Lane expired = F32Lane_LessOrEqual(F32Lane_Load(table->countdown_secs_before_dead + idx), zero);
+    for (u32 remove_mask = F32Lane_MoveMask(F32Lane_Or(touched, expired)); remove_mask; remove_mask &= remove_mask - 1)
+    {
+      table->removals[result++] = (u32)(idx + CountTrailingZerosU64(remove_mask));
+    }
+  }
+#endif
+  for (; idx < table->count; ++idx)
+  {
+    b32 touched = ((absolute_value_f32(table->x[idx] - player_p.x) <= reach_x) &&
+                   (absolute_value_f32(table->y[idx] - player_p.y) <= reach_y));
+    if (touched || (table->countdown_secs_before_dead[idx] <= 0))
+    {
+      table->removals[result++] = (u32)idx;
+    }
+  }
+  return(result);
+}
+
+// NOTE(cj): the closest gem to gem_idx within radius that has settled and is
+// still alive, ties going to the lower index. gem_idx if there's none.
+function u64
+experience_gems_find_merge_target(Experience_Gem_Table *table, u64 gem_idx, f32 radius)
+{
+  u64 result = gem_idx;
+  f32 p_x = table->x[gem_idx];
+  f32 p_y = table->y[gem_idx];
+  f32 best_distance_sq = radius*radius;
+  u64 idx = 0;
+#define GemMerge_Consider(other_idx, distance_sq) \
+if (((other_idx) != gem_idx) && \
+((result == gem_idx) ? ((distance_sq) <= best_distance_sq) : ((distance_sq) < best_distance_sq))) \
+{ \
+result = (other_idx); \
+best_distance_sq = (distance_sq); \
+}
+#if defined(F32Lane_Width)
+  F32Lane zero = F32Lane_Set1(0.0f);
+  F32Lane p_x_lane = F32Lane_Set1(p_x);
+  F32Lane p_y_lane = F32Lane_Set1(p_y);
+  for (; (idx + F32Lane_Width) <= table->count; idx += F32Lane_Width)
+  {
+    F32Lane dx = F32Lane_Sub(F32Lane_Load(table->x + idx), p_x_lane);
+    F32Lane dy = F32Lane_Sub(F32Lane_Load(table->y + idx), p_y_lane);
+    F32Lane distance_sq = F32Lane_Add(F32Lane_Mul(dx, dx), F32Lane_Mul(dy, dy));
+    F32Lane candidate = F32Lane_And(F32Lane_LessOrEqual(distance_sq, F32Lane_Set1(best_distance_sq)),
+                                    F32Lane_And(F32Lane_LessOrEqual(F32Lane_Load(table->t_countdown + idx), zero),
+                                                F32Lane_GreaterThan(F32Lane_Load(table->countdown_secs_before_dead + idx), zero)));
+    u32 candidate_mask = F32Lane_MoveMask(candidate);
+    if (candidate_mask)
+    {
+      f32 lane_distance_sq[F32Lane_Width];
+      F32Lane_Store(lane_distance_sq, distance_sq);
+      for (; candidate_mask; candidate_mask &= candidate_mask - 1)
+      {
+        u64 lane = CountTrailingZerosU64(candidate_mask);
+        GemMerge_Consider(idx + lane, lane_distance_sq[lane]);
+      }
+    }
+  }
+#endif
+  for (; idx < table->count; ++idx)
+  {
+    if ((table->t_countdown[idx] <= 0) && (table->countdown_secs_before_dead[idx] > 0))
+    {
+      f32 dx = table->x[idx] - p_x;
+      f32 dy = table->y[idx] - p_y;
+      f32 distance_sq = dx*dx + dy*dy;
+      GemMerge_Consider(idx, distance_sq);
+    }
+  }
+#undef GemMerge_Consider
+  return(result);
+}
+
+// NOTE(cj): A gem that just landed merges into the closest settled gem near it.
+// Settled gems only move toward the player, so landing is the only time two of
+// them come together. The merged gem gets a value of 0 and no time left, so the
+// removal drops it without it giving anything. The gem it went into keeps the
+// longer of the two lifetimes.
+function void
+experience_gems_merge_landed(Experience_Gem_Table *table, u64 landed_count, f32 radius)
+{
+  ForLoopU64(landed_idx, landed_count)
+  {
+    u32 gem_idx = table->landed[landed_idx];
+    u64 into_idx = experience_gems_find_merge_target(table, gem_idx, radius);
+    if (into_idx != gem_idx)
+    {
+      table->value[into_idx] += table->value[gem_idx];
+      table->countdown_secs_before_dead[into_idx] = Max(table->countdown_secs_before_dead[into_idx], table->countdown_secs_before_dead[gem_idx]);
+      table->value[gem_idx] = 0;
+      table->countdown_secs_before_dead[gem_idx] = 0.0f;
+    }
+  }
+}
+
+// NOTE(cj): moves settled, living gems within radius of target up to step toward it
+function void
+experience_gems_attract(Experience_Gem_Table *table, v2f target, f32 radius, f32 step)
+{
+  f32 radius_sq = radius*radius;
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane zero = F32Lane_Set1(0.0f);
+  F32Lane one = F32Lane_Set1(1.0f);
+  F32Lane target_x = F32Lane_Set1(target.x);
+  F32Lane target_y = F32Lane_Set1(target.y);
+  F32Lane radius_sq_lane = F32Lane_Set1(radius_sq);
+  F32Lane step_lane = F32Lane_Set1(step);
+  for (; (idx + F32Lane_Width) <= table->count; idx += F32Lane_Width)
+  {
+    F32Lane x = F32Lane_Load(table->x + idx);
+    F32Lane y = F32Lane_Load(table->y + idx);
+    F32Lane dx = F32Lane_Sub(target_x, x);
+    F32Lane dy = F32Lane_Sub(target_y, y);
+    F32Lane distance_sq = F32Lane_Add(F32Lane_Mul(dx, dx), F32Lane_Mul(dy, dy));
+    F32Lane attracted = F32Lane_And(F32Lane_LessOrEqual(distance_sq, radius_sq_lane),
+                                    F32Lane_And(F32Lane_LessOrEqual(F32Lane_Load(table->t_countdown + idx), zero),
+                                                F32Lane_GreaterThan(F32Lane_Load(table->countdown_secs_before_dead + idx), zero)));
+    if (F32Lane_MoveMask(attracted))
+    {
+      F32Lane distance = F32Lane_Sqrt(distance_sq);
+      F32Lane scale = F32Lane_Select(F32Lane_GreaterThan(distance, step_lane), F32Lane_Div(step_lane, distance), one);
+      F32Lane_Store(table->x + idx, F32Lane_Select(attracted, F32Lane_Add(x, F32Lane_Mul(dx, scale)), x));
+      F32Lane_Store(table->y + idx, F32Lane_Select(attracted, F32Lane_Add(y, F32Lane_Mul(dy, scale)), y));
+    }
+  }
+#endif
+  for (; idx < table->count; ++idx)
+  {
+    f32 dx = target.x - table->x[idx];
+    f32 dy = target.y - table->y[idx];
+    f32 distance_sq = dx*dx + dy*dy;
+    if ((distance_sq <= radius_sq) && (table->t_countdown[idx] <= 0) && (table->countdown_secs_before_dead[idx] > 0))
+    {
+      f32 distance = sqrtf(distance_sq);
+      f32 scale = (distance > step) ? (step / distance) : 1.0f;
+      table->x[idx] += dx*scale;
+      table->y[idx] += dy*scale;
+    }
+  }
+}
@@ -0,0 +1,77 @@
+/* date = October 17th 2026 9:20 pm */
+
+#ifndef EXPERIENCE_GEMS_H
+#define EXPERIENCE_GEMS_H
+
+//
+// NOTE(cj): Experience gems, a structure of arrays like the entities. A gem is an
+// index, and removal moves the last gem into the hole. Gems fly on a ballistic
+// arc for t_countdown seconds after they spawn, then sit still until they are
+// picked up or countdown_secs_before_dead runs out. They are all the same size.
+//
+// A gem that lands within a merge radius of a settled gem merges into it, so a
+// pile of kills costs one gem worth their sum rather than hundreds. Settled gems
+// within the player's magnet_radius fly to the player.
+//
+// NOTE(cj): merge and magnet scan every gem instead of asking a Spatial_Grid.
+// Gems move every step, so a grid would have to be rebuilt every step, at 10-17
+// ns a gem, and the rebuild alone costs more than all the scans it saves.
+// bench_experience_gems ("tests bench") times both, us per step with 5 gems
+// landing (avx2; sse2 is 2-3x slower, the grid is still 3.5-4x behind):
+//    gems    scan    grid
+//      64    0.18    0.92
+//     256    0.44    3.46
+//    1024    1.55   11.96
+//    4096    6.05   52.20
+// Only without simd does the grid catch up, somewhere past 4096 gems. The game
+// stays well below that. The 20 wave report ("headless walls 20 [stress_every]",
+// bottom of main.c) on the same machine, avx2:
+//                          avg gems  max gems  step us  gem update us
+//    plain                      2.5        26      6.2           0.06
+//    a kill every 6 steps     440.0       477      7.7           1.20
+//    a kill every step        980.8      1025     10.4           4.10
+//
+// NOTE(cj): gems used to be nodes in a list threaded through a pool.
+// bench_gem_layout times the per step update (integrate, pickup, countdown) on
+// the same gems both ways, the list linked in random order the way churn leaves
+// it, ns per gem:
+//    gems    list   table (sse2)  table (avx2)
+//    1000    13.1            2.4           1.4
+//   10000    23.8            2.5           1.7
+//  100000   112.6            2.9           2.7
+// Past the cache the list is a pointer chase per gem, 26-40x behind the table.
+//
+#define ExperienceGem_G 700.0f
+#define ExperienceGem_Dim 16.0f
+#define ExperienceGem_Value 2
+
+typedef struct
+{
+  M_Arena *arena;
+  u64 count;
+  u64 capacity;
+  
+  f32 *x, *y, *z;
+  f32 *prev_x, *prev_y; // p at the start of the current sim step
+  f32 *dP_x, *dP_y, *dP_z;
+  f32 *t_countdown;
+  f32 *countdown_secs_before_dead;
+  u32 *value; // experience it gives, 0 once it merged into another gem
+  
+  // NOTE(cj): scratch, the gems that landed and the gems to remove this step, in
+  // ascending order
+  u32 *landed;
+  u32 *removals;
+} Experience_Gem_Table;
+
+function void experience_gem_table_init(Experience_Gem_Table *table, M_Arena *arena, u64 initial_capacity);
+function void experience_gem_table_reserve(Experience_Gem_Table *table, u64 capacity);
+function void experience_gem_swap_remove(Experience_Gem_Table *table, u64 idx);
+
+function u64 experience_gems_integrate(Experience_Gem_Table *table, f32 dt);
+function u64 experience_gems_find_merge_target(Experience_Gem_Table *table, u64 gem_idx, f32 radius);
+function void experience_gems_merge_landed(Experience_Gem_Table *table, u64 landed_count, f32 radius);
+function void experience_gems_attract(Experience_Gem_Table *table, v2f target, f32 radius, f32 step);
+function u64 experience_gems_collect_removals(Experience_Gem_Table *table, v2f player_p, v2f player_half_dims);
+
+#endif //EXPERIENCE_GEMS_H
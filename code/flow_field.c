@@ -0,0 +1,252 @@
+function void
+flow_field_init(Flow_Field *field, M_Arena *arena, u32 width, u32 height, f32 cell_size)
+{
+  Assert((width > 0) && (height > 0) && (cell_size > 0.0f));
+  ClearStructP(field);
+  field->width = width;
+  field->height = height;
+  field->stride = width + 2;
+  field->cell_size = cell_size;
+  field->inv_cell_size = 1.0f / cell_size;
+  
+  u64 padded_count = (u64)(width + 2) * (u64)(height + 2);
+  field->blocked = M_Arena_PushArray(arena, u8, padded_count);
+  field->cost = M_Arena_PushArray(arena, f32, padded_count);
+  field->dir_x = M_Arena_PushArray(arena, f32, padded_count);
+  field->dir_y = M_Arena_PushArray(arena, f32, padded_count);
+  field->queue = M_Arena_PushArray(arena, u32, padded_count);
+}
+
+inline function s32
+flow_field_cell_coord(Flow_Field *field, f32 v)
+{
+  s32 result = (s32)floorf(v * field->inv_cell_size);
+  return(result);
+}
+
+function void
+flow_field_begin(Flow_Field *field, v2f center)
+{
+  field->origin_cell_x = flow_field_cell_coord(field, center.x) - (s32)(field->width / 2);
+  field->origin_cell_y = flow_field_cell_coord(field, center.y) - (s32)(field->height / 2);
+  field->valid = 0;
+  
+  u64 padded_count = (u64)field->stride * (u64)(field->height + 2);
+  MemoryClear(field->blocked, padded_count);
+  memset(field->blocked, 1, field->stride);
+  memset(field->blocked + (u64)field->stride * (field->height + 1), 1, field->stride);
+  for (u32 row = 1; row <= field->height; ++row)
+  {
+    field->blocked[(u64)row * field->stride] = 1;
+    field->blocked[(u64)row * field->stride + field->width + 1] = 1;
+  }
+}
+
+// NOTE(cj): blocks every cell the rect touches
+function void
+flow_field_block_rect(Flow_Field *field, v2f p, v2f half_dims)
+{
+  s32 cell_x0 = Max(flow_field_cell_coord(field, p.x - half_dims.x) - field->origin_cell_x, 0);
+  s32 cell_y0 = Max(flow_field_cell_coord(field, p.y - half_dims.y) - field->origin_cell_y, 0);
+  s32 cell_x1 = Min(flow_field_cell_coord(field, p.x + half_dims.x) - field->origin_cell_x, (s32)field->width - 1);
+  s32 cell_y1 = Min(flow_field_cell_coord(field, p.y + half_dims.y) - field->origin_cell_y, (s32)field->height - 1);
+  for (s32 cell_y = cell_y0; cell_y <= cell_y1; ++cell_y)
+  {
+    for (s32 cell_x = cell_x0; cell_x <= cell_x1; ++cell_x)
+    {
+      field->blocked[(u64)(cell_y + 1) * field->stride + (u64)(cell_x + 1)] = 1;
+    }
+  }
+}
+
+// NOTE(cj): the cheapest of the 8 neighbors, if it's cheaper than the cell itself.
+// Straight neighbors are checked first so they win ties. A diagonal only counts
+// when both straight cells beside it are open, so nothing cuts a wall's corner.
+// Only compares and selects, so the SIMD version gives exactly the same result.
+function void
+flow_field_direction_for_cell(Flow_Field *field, u64 idx)
+{
+  f32 *cost = field->cost;
+  u64 stride = field->stride;
+  f32 left = cost[idx - 1];
+  f32 right = cost[idx + 1];
+  f32 down = cost[idx - stride];
+  f32 up = cost[idx + stride];
+  
+  f32 best = cost[idx];
+  f32 dir_x = 0.0f;
+  f32 dir_y = 0.0f;
+#define FlowField_Consider(c, dx, dy) if ((c) < best) { best = (c); dir_x = (dx); dir_y = (dy); }
+  FlowField_Consider(left, -1.0f, 0.0f);
+  FlowField_Consider(right, 1.0f, 0.0f);
+  FlowField_Consider(down, 0.0f, -1.0f);
+  FlowField_Consider(up, 0.0f, 1.0f);
+  if ((left < FlowField_Unreachable) && (down < FlowField_Unreachable))
+  {
+    FlowField_Consider(cost[idx - stride - 1], -FlowField_Diagonal, -FlowField_Diagonal);
+  }
+  if ((right < FlowField_Unreachable) && (down < FlowField_Unreachable))
+  {
+    FlowField_Consider(cost[idx - stride + 1], FlowField_Diagonal, -FlowField_Diagonal);
+  }
+  if ((left < FlowField_Unreachable) && (up < FlowField_Unreachable))
+  {
+    FlowField_Consider(cost[idx + stride - 1], -FlowField_Diagonal, FlowField_Diagonal);
+  }
+  if ((right < FlowField_Unreachable) && (up < FlowField_Unreachable))
+  {
+    FlowField_Consider(cost[idx + stride + 1], FlowField_Diagonal, FlowField_Diagonal);
+  }
+#undef FlowField_Consider
+
+  field->dir_x[idx] = dir_x;
+  field->dir_y[idx] = dir_y;
+}
+
+// NOTE(cj): directions, a row at a time
+function void
+flow_field_compute_directions(Flow_Field *field)
+{
+#if defined(F32Lane_Width)
+  f32 *cost = field->cost;
+  F32Lane unreachable = F32Lane_Set1(FlowField_Unreachable);
+  F32Lane blocked_cost = F32Lane_Set1(FlowField_BlockedCost);
+  F32Lane zero = F32Lane_Set1(0.0f);
+  F32Lane one = F32Lane_Set1(1.0f);
+  F32Lane minus_one = F32Lane_Set1(-1.0f);
+  F32Lane diagonal = F32Lane_Set1(FlowField_Diagonal);
+  F32Lane minus_diagonal = F32Lane_Set1(-FlowField_Diagonal);
+#endif
+  for (u32 row = 1; row <= field->height; ++row)
+  {
+    u64 idx = (u64)row * field->stride + 1;
+    u64 row_end = idx + field->width;
+#if defined(F32Lane_Width)
+    for (; (idx + F32Lane_Width) <= row_end; idx += F32Lane_Width)
+    {
+      F32Lane left = F32Lane_Load(cost + idx - 1);
+      F32Lane right = F32Lane_Load(cost + idx + 1);
+      F32Lane down = F32Lane_Load(cost + idx - field->stride);
+      F32Lane up = F32Lane_Load(cost + idx + field->stride);
+      F32Lane left_open = F32Lane_GreaterThan(unreachable, left);
+      F32Lane right_open = F32Lane_GreaterThan(unreachable, right);
+      F32Lane down_open = F32Lane_GreaterThan(unreachable, down);
+      F32Lane up_open = F32Lane_GreaterThan(unreachable, up);
+      
+      F32Lane best = F32Lane_Load(cost + idx);
+      F32Lane dir_x = zero;
+      F32Lane dir_y = zero;
+      F32Lane better;
+      F32Lane c;
+#define FlowField_ConsiderLane(c, dx, dy) \
+better = F32Lane_GreaterThan(best, (c));\
+best = F32Lane_Select(better, (c), best);\
+dir_x = F32Lane_Select(better, (dx), dir_x);\
+dir_y = F32Lane_Select(better, (dy), dir_y)
+      FlowField_ConsiderLane(left, minus_one, zero);
+      FlowField_ConsiderLane(right, one, zero);
+      FlowField_ConsiderLane(down, zero, minus_one);
+      FlowField_ConsiderLane(up, zero, one);
+      c = F32Lane_Select(F32Lane_And(left_open, down_open), F32Lane_Load(cost + idx - field->stride - 1), blocked_cost);
+      FlowField_ConsiderLane(c, minus_diagonal, minus_diagonal);
+      c = F32Lane_Select(F32Lane_And(right_open, down_open), F32Lane_Load(cost + idx - field->stride + 1), blocked_cost);
+      FlowField_ConsiderLane(c, diagonal, minus_diagonal);
+      c = F32Lane_Select(F32Lane_And(left_open, up_open), F32Lane_Load(cost + idx + field->stride - 1), blocked_cost);
+      FlowField_ConsiderLane(c, minus_diagonal, diagonal);
+      c = F32Lane_Select(F32Lane_And(right_open, up_open), F32Lane_Load(cost + idx + field->stride + 1), blocked_cost);
+      FlowField_ConsiderLane(c, diagonal, diagonal);
+#undef FlowField_ConsiderLane
+
+      F32Lane_Store(field->dir_x + idx, dir_x);
+      F32Lane_Store(field->dir_y + idx, dir_y);
+    }
+#endif
+    for (; idx < row_end; ++idx)
+    {
+      flow_field_direction_for_cell(field, idx);
+    }
+  }
+}
+
+function void
+flow_field_integrate(Flow_Field *field, v2f target)
+{
+  u64 padded_count = (u64)field->stride * (u64)(field->height + 2);
+  f32 *cost = field->cost;
+  for (u64 idx = 0; idx < padded_count; ++idx)
+  {
+    cost[idx] = field->blocked[idx] ? FlowField_BlockedCost : FlowField_Unreachable;
+  }
+  
+  field->target_cell_x = flow_field_cell_coord(field, target.x);
+  field->target_cell_y = flow_field_cell_coord(field, target.y);
+  s32 target_x = field->target_cell_x - field->origin_cell_x;
+  s32 target_y = field->target_cell_y - field->origin_cell_y;
+  u64 target_idx = (u64)(target_y + 1) * field->stride + (u64)(target_x + 1);
+  field->valid = ((target_x >= 0) && (target_x < (s32)field->width) &&
+                  (target_y >= 0) && (target_y < (s32)field->height) &&
+                  !field->blocked[target_idx]);
+  
+  if (field->valid)
+  {
+    //
+    // NOTE(cj): BFS. Only unvisited open cells have a cost of exactly
+    // FlowField_Unreachable, so that one compare skips blocked and visited cells.
+    // The border is blocked, so neighbors never leave the arrays.
+    //
+    u32 *queue = field->queue;
+    u32 stride = field->stride;
+    u32 head = 0;
+    u32 tail = 0;
+    cost[target_idx] = 0.0f;
+    queue[tail++] = (u32)target_idx;
+    while (head < tail)
+    {
+      u32 idx = queue[head++];
+      f32 next_cost = cost[idx] + 1.0f;
+      u32 neighbors[4] = { idx - 1, idx + 1, idx - stride, idx + stride };
+      for (u32 neighbor_idx = 0; neighbor_idx < ArrayCount(neighbors); ++neighbor_idx)
+      {
+        u32 neighbor = neighbors[neighbor_idx];
+        if (cost[neighbor] == FlowField_Unreachable)
+        {
+          cost[neighbor] = next_cost;
+          queue[tail++] = neighbor;
+        }
+      }
+    }
+  }
+  
+  flow_field_compute_directions(field);
+}
+
+function b32
+flow_field_is_current(Flow_Field *field, v2f target)
+{
+  b32 result = (field->valid &&
+                (flow_field_cell_coord(field, target.x) == field->target_cell_x) &&
+                (flow_field_cell_coord(field, target.y) == field->target_cell_y));
+  return(result);
+}
+
+function b32
+flow_field_sample(Flow_Field *field, v2f p, v2f *direction)
+{
+  b32 result = 0;
+  if (field->valid)
+  {
+    s32 cell_x = flow_field_cell_coord(field, p.x) - field->origin_cell_x;
+    s32 cell_y = flow_field_cell_coord(field, p.y) - field->origin_cell_y;
+    if ((cell_x >= 0) && (cell_x < (s32)field->width) && (cell_y >= 0) && (cell_y < (s32)field->height))
+    {
+      u64 idx = (u64)(cell_y + 1) * field->stride + (u64)(cell_x + 1);
+      v2f dir = v2f_make(field->dir_x[idx], field->dir_y[idx]);
+      result = ((dir.x != 0.0f) || (dir.y != 0.0f));
+      if (result)
+      {
+        *direction = dir;
+      }
+    }
+  }
+  return(result);
+}
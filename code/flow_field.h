@@ -0,0 +1,60 @@
+/* date = October 17th 2026 6:05 pm */
+
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+//
+// NOTE(cj): Flow field toward a single target, for steering a whole horde around
+// obstacles at once. The field is a width x height window of square cells
+// centered on the target's cell. Integration is a BFS from the target cell
+// (4-connected, one step per cell) that gives every open cell its distance to
+// the target. A second pass (SIMD) gives each cell the direction to its
+// cheapest neighbor, so steering an entity is one lookup in its cell.
+//
+// Rebuild it when the target changes cell or the obstacles change:
+// flow_field_begin, flow_field_block_rect for every obstacle, flow_field_integrate.
+//
+// The arrays have a one cell border of blocked cells around the window, so the
+// passes never check bounds.
+//
+// bench_flow_field ("tests bench"), a sixth of the cells walled, ms (avx2):
+//       window  rebuild  direction pass  (scalar)
+//      256x256     0.75            0.10      0.51
+//    1024x1024    12.8             1.8       8.2
+// The game's Game_FlowFieldDim window is 128x128, a quarter of the small one.
+//
+#define FlowField_Unreachable 1e30f
+#define FlowField_BlockedCost 2e30f
+#define FlowField_Diagonal 0.707106781f // 1/sqrt(2)
+
+typedef struct
+{
+  u32 width, height; // cells, without the border
+  u32 stride;        // width + 2
+  f32 cell_size;
+  f32 inv_cell_size;
+  
+  // NOTE(cj): world cell of the window's first cell, and of the target
+  s32 origin_cell_x, origin_cell_y;
+  s32 target_cell_x, target_cell_y;
+  b32 valid; // integrated and the target was in an open cell
+  
+  u8 *blocked;
+  f32 *cost; // steps to the target, FlowField_Unreachable if there's no way there, FlowField_BlockedCost if blocked
+  // NOTE(cj): unit length, or zero at the target and in open cells cut off from it.
+  // Blocked cells next to open ones point out of the wall.
+  f32 *dir_x, *dir_y;
+  u32 *queue;
+} Flow_Field;
+
+function void flow_field_init(Flow_Field *field, M_Arena *arena, u32 width, u32 height, f32 cell_size);
+function void flow_field_begin(Flow_Field *field, v2f center);
+function void flow_field_block_rect(Flow_Field *field, v2f p, v2f half_dims);
+function void flow_field_integrate(Flow_Field *field, v2f target);
+// NOTE(cj): true when the field was integrated for the cell target is in now
+function b32  flow_field_is_current(Flow_Field *field, v2f target);
+// NOTE(cj): false outside the window and where there's no direction to go (the
+// target cell, cells cut off from it)
+function b32  flow_field_sample(Flow_Field *field, v2f p, v2f *direction);
+
+#endif //FLOW_FIELD_H
@@ -96,6 +96,16 @@ v3f_sub_and_normalize_or_zero(v3f a, v3f b)
   return(result);
 }
 
+inline function v3f
+v3f_lerp(v3f a, v3f b, f32 t)
+{
+  v3f result;
+  result.x = a.x + (b.x - a.x) * t;
+  result.y = a.y + (b.y - a.y) * t;
+  result.z = a.z + (b.z - a.z) * t;
+  return(result);
+}
+
 inline function v4f
 v4f_make(f32 x, f32 y, f32 z, f32 w)
 {
@@ -121,4 +131,359 @@ m44_make_orthographic_z01(f32 left, f32 right, f32 top, f32 bottom, f32 near_pla
     -(right + left) / rml, -(top + bottom) / tmb,  -near_plane / (far_plane - near_plane), 1.0f,
   };
   return(result);
-}
\ No newline at end of file
+}
+
+function void
+f32_batch_add(f32 *dest, f32 *a, f32 *b, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane_Store(dest + idx, F32Lane_Add(F32Lane_Load(a + idx), F32Lane_Load(b + idx)));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = a[idx] + b[idx];
+  }
+}
+
+function void
+f32_batch_scale(f32 *dest, f32 *a, f32 s, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane s_wide = F32Lane_Set1(s);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane_Store(dest + idx, F32Lane_Mul(F32Lane_Load(a + idx), s_wide));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = a[idx] * s;
+  }
+}
+
+function void
+f32_batch_add_scaled(f32 *dest, f32 *a, f32 *b, f32 s, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane s_wide = F32Lane_Set1(s);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane_Store(dest + idx, F32Lane_Add(F32Lane_Load(a + idx), F32Lane_Mul(F32Lane_Load(b + idx), s_wide)));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = a[idx] + b[idx] * s;
+  }
+}
+
+function void
+f32_batch_lerp(f32 *dest, f32 *a, f32 *b, f32 t, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane t_wide = F32Lane_Set1(t);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane a_wide = F32Lane_Load(a + idx);
+    F32Lane_Store(dest + idx, F32Lane_Add(a_wide, F32Lane_Mul(F32Lane_Sub(F32Lane_Load(b + idx), a_wide), t_wide)));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = a[idx] + (b[idx] - a[idx]) * t;
+  }
+}
+
+function void
+v3f_batch_lerp(v3f_soa dest, v3f_soa a, v3f_soa b, f32 t, u64 count)
+{
+  f32_batch_lerp(dest.x, a.x, b.x, t, count);
+  f32_batch_lerp(dest.y, a.y, b.y, t, count);
+  f32_batch_lerp(dest.z, a.z, b.z, t, count);
+}
+
+function void
+v3f_batch_sub_and_normalize_or_zero(v3f_soa dest, v3f_soa a, v3f_soa b, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  // NOTE(cj): same sqrt and divide as the scalar version (not rsqrt), so the
+  // results match it bit for bit
+  F32Lane tolerance = F32Lane_Set1(0.0001f);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane x = F32Lane_Sub(F32Lane_Load(a.x + idx), F32Lane_Load(b.x + idx));
+    F32Lane y = F32Lane_Sub(F32Lane_Load(a.y + idx), F32Lane_Load(b.y + idx));
+    F32Lane z = F32Lane_Sub(F32Lane_Load(a.z + idx), F32Lane_Load(b.z + idx));
+    F32Lane length = F32Lane_Sqrt(F32Lane_Add(F32Lane_Add(F32Lane_Mul(x, x), F32Lane_Mul(y, y)), F32Lane_Mul(z, z)));
+    F32Lane keep = F32Lane_GreaterThan(length, tolerance);
+    F32Lane_Store(dest.x + idx, F32Lane_And(F32Lane_Div(x, length), keep));
+    F32Lane_Store(dest.y + idx, F32Lane_And(F32Lane_Div(y, length), keep));
+    F32Lane_Store(dest.z + idx, F32Lane_And(F32Lane_Div(z, length), keep));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    v3f n = v3f_sub_and_normalize_or_zero(v3f_make(a.x[idx], a.y[idx], a.z[idx]),
+                                          v3f_make(b.x[idx], b.y[idx], b.z[idx]));
+    dest.x[idx] = n.x;
+    dest.y[idx] = n.y;
+    dest.z[idx] = n.z;
+  }
+}
+
+function void
+v3f_batch_distance_sq(f32 *dest, v3f_soa a, v3f b, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane bx = F32Lane_Set1(b.x);
+  F32Lane by = F32Lane_Set1(b.y);
+  F32Lane bz = F32Lane_Set1(b.z);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane x = F32Lane_Sub(F32Lane_Load(a.x + idx), bx);
+    F32Lane y = F32Lane_Sub(F32Lane_Load(a.y + idx), by);
+    F32Lane z = F32Lane_Sub(F32Lane_Load(a.z + idx), bz);
+    F32Lane_Store(dest + idx, F32Lane_Add(F32Lane_Add(F32Lane_Mul(x, x), F32Lane_Mul(y, y)), F32Lane_Mul(z, z)));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    f32 x = a.x[idx] - b.x;
+    f32 y = a.y[idx] - b.y;
+    f32 z = a.z[idx] - b.z;
+    dest[idx] = x*x + y*y + z*z;
+  }
+}
+
+
+//
+// NOTE(cj): sin/cos. Reduce x to r in [-pi/4, pi/4] with x = q*pi/2 + r (pi/2 split in
+// two so q*hi is exact), evaluate the cephes minimax polynomials for sin and cos on
+// r, then pick/negate by the quadrant q mod 4.
+//
+#define F32_TwoOverPi 0.636619772367581f
+#define F32_PiOverTwoHi 1.5703125f
+#define F32_PiOverTwoLo 4.83826794897e-4f
+
+#define F32_SinC0 -1.6666654611e-1f
+#define F32_SinC1 8.3321608736e-3f
+#define F32_SinC2 -1.9515295891e-4f
+#define F32_CosC0 4.166664568298827e-2f
+#define F32_CosC1 -1.388731625493765e-3f
+#define F32_CosC2 2.443315711809948e-5f
+
+inline function void
+f32_sincos_fast(f32 x, f32 *sin_out, f32 *cos_out)
+{
+  f32 qf = x * F32_TwoOverPi;
+  s32 q = (s32)(qf + ((qf >= 0.0f) ? 0.5f : -0.5f));
+  qf = (f32)q;
+  f32 r = (x - qf * F32_PiOverTwoHi) - qf * F32_PiOverTwoLo;
+  f32 z = r * r;
+  
+  f32 s = r + r * z * (F32_SinC0 + z * (F32_SinC1 + z * F32_SinC2));
+  f32 c = 1.0f - 0.5f * z + z * z * (F32_CosC0 + z * (F32_CosC1 + z * F32_CosC2));
+  
+  f32 sin_result = (q & 1) ? c : s;
+  f32 cos_result = (q & 1) ? s : c;
+  if (q & 2)
+  {
+    sin_result = -sin_result;
+  }
+  if ((q + 1) & 2)
+  {
+    cos_result = -cos_result;
+  }
+  
+  *sin_out = sin_result;
+  *cos_out = cos_result;
+}
+
+inline function f32
+f32_sin_fast(f32 x)
+{
+  f32 result, unused;
+  f32_sincos_fast(x, &result, &unused);
+  return(result);
+}
+
+inline function f32
+f32_cos_fast(f32 x)
+{
+  f32 result, unused;
+  f32_sincos_fast(x, &unused, &result);
+  return(result);
+}
+
+inline function f32
+f32_rsqrt_fast(f32 x)
+{
+#if defined(DR_SIMD_SSE2)
+  f32 result = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+  result = result * (1.5f - 0.5f * x * result * result);
+#else
+  u32 bits;
+  MemoryCopy(&bits, &x, sizeof(bits));
+  bits = 0x5f375a86 - (bits >> 1);
+  f32 result;
+  MemoryCopy(&result, &bits, sizeof(result));
+  result = result * (1.5f - 0.5f * x * result * result);
+  result = result * (1.5f - 0.5f * x * result * result);
+#endif
+  return(result);
+}
+
+inline function v3f
+v3f_sub_and_normalize_or_zero_fast(v3f a, v3f b)
+{
+  v3f result;
+  result.x = a.x - b.x;
+  result.y = a.y - b.y;
+  result.z = a.z - b.z;
+  
+  // NOTE(cj): same cutoff as the exact version, length <= 0.0001
+  f32 length_sq = result.x*result.x + result.y*result.y + result.z*result.z;
+  if (length_sq <= 0.0001f*0.0001f)
+  {
+    result.x = result.y = result.z = 0.0f;
+  }
+  else
+  {
+    f32 inv_length = f32_rsqrt_fast(length_sq);
+    result.x *= inv_length;
+    result.y *= inv_length;
+    result.z *= inv_length;
+  }
+  
+  return(result);
+}
+
+#if defined(F32Lane_Width)
+inline function F32Lane
+f32_lane_rsqrt_fast(F32Lane x)
+{
+  F32Lane y = F32Lane_RSqrt(x);
+  F32Lane xyy = F32Lane_Mul(F32Lane_Mul(x, y), y);
+  F32Lane result = F32Lane_Mul(y, F32Lane_Sub(F32Lane_Set1(1.5f), F32Lane_Mul(F32Lane_Set1(0.5f), xyy)));
+  return(result);
+}
+#endif
+
+function void
+f32_batch_sincos_fast(f32 *sin_out, f32 *cos_out, f32 *x, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  I32Lane one = I32Lane_Set1(1);
+  I32Lane two = I32Lane_Set1(2);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane v = F32Lane_Load(x + idx);
+    I32Lane q = F32Lane_RoundToI32(F32Lane_Mul(v, F32Lane_Set1(F32_TwoOverPi)));
+    F32Lane qf = I32Lane_ToF32(q);
+    F32Lane r = F32Lane_Sub(F32Lane_Sub(v, F32Lane_Mul(qf, F32Lane_Set1(F32_PiOverTwoHi))),
+                            F32Lane_Mul(qf, F32Lane_Set1(F32_PiOverTwoLo)));
+    F32Lane z = F32Lane_Mul(r, r);
+    
+    F32Lane s = F32Lane_Add(F32Lane_Set1(F32_SinC1), F32Lane_Mul(z, F32Lane_Set1(F32_SinC2)));
+    s = F32Lane_Add(F32Lane_Set1(F32_SinC0), F32Lane_Mul(z, s));
+    s = F32Lane_Add(r, F32Lane_Mul(F32Lane_Mul(r, z), s));
+    
+    F32Lane c = F32Lane_Add(F32Lane_Set1(F32_CosC1), F32Lane_Mul(z, F32Lane_Set1(F32_CosC2)));
+    c = F32Lane_Add(F32Lane_Set1(F32_CosC0), F32Lane_Mul(z, c));
+    c = F32Lane_Add(F32Lane_Sub(F32Lane_Set1(1.0f), F32Lane_Mul(F32Lane_Set1(0.5f), z)), F32Lane_Mul(F32Lane_Mul(z, z), c));
+    
+    F32Lane swap = F32Lane_FromBits(I32Lane_Equal(I32Lane_And(q, one), one));
+    F32Lane sin_sign = F32Lane_FromBits(I32Lane_ShiftLeft(I32Lane_And(q, two), 30));
+    F32Lane cos_sign = F32Lane_FromBits(I32Lane_ShiftLeft(I32Lane_And(I32Lane_Add(q, one), two), 30));
+    F32Lane sin_result = F32Lane_Or(F32Lane_And(swap, c), F32Lane_AndNot(swap, s));
+    F32Lane cos_result = F32Lane_Or(F32Lane_And(swap, s), F32Lane_AndNot(swap, c));
+    F32Lane_Store(sin_out + idx, F32Lane_Xor(sin_result, sin_sign));
+    F32Lane_Store(cos_out + idx, F32Lane_Xor(cos_result, cos_sign));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    f32_sincos_fast(x[idx], sin_out + idx, cos_out + idx);
+  }
+}
+
+function void
+f32_batch_rsqrt_fast(f32 *dest, f32 *x, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane_Store(dest + idx, f32_lane_rsqrt_fast(F32Lane_Load(x + idx)));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = f32_rsqrt_fast(x[idx]);
+  }
+}
+
+function void
+v3f_batch_sub_and_normalize_or_zero_fast(v3f_soa dest, v3f_soa a, v3f_soa b, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane tolerance_sq = F32Lane_Set1(0.0001f*0.0001f);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane x = F32Lane_Sub(F32Lane_Load(a.x + idx), F32Lane_Load(b.x + idx));
+    F32Lane y = F32Lane_Sub(F32Lane_Load(a.y + idx), F32Lane_Load(b.y + idx));
+    F32Lane z = F32Lane_Sub(F32Lane_Load(a.z + idx), F32Lane_Load(b.z + idx));
+    F32Lane length_sq = F32Lane_Add(F32Lane_Add(F32Lane_Mul(x, x), F32Lane_Mul(y, y)), F32Lane_Mul(z, z));
+    F32Lane inv_length = F32Lane_And(f32_lane_rsqrt_fast(length_sq), F32Lane_GreaterThan(length_sq, tolerance_sq));
+    F32Lane_Store(dest.x + idx, F32Lane_Mul(x, inv_length));
+    F32Lane_Store(dest.y + idx, F32Lane_Mul(y, inv_length));
+    F32Lane_Store(dest.z + idx, F32Lane_Mul(z, inv_length));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    v3f n = v3f_sub_and_normalize_or_zero_fast(v3f_make(a.x[idx], a.y[idx], a.z[idx]),
+                                               v3f_make(b.x[idx], b.y[idx], b.z[idx]));
+    dest.x[idx] = n.x;
+    dest.y[idx] = n.y;
+    dest.z[idx] = n.z;
+  }
+}
+
+function void
+v2f_batch_step_toward_fast(f32 *dest_x, f32 *dest_y, f32 *x, f32 *y, v2f target, f32 step, u64 count)
+{
+  u64 idx = 0;
+#if defined(F32Lane_Width)
+  F32Lane tolerance_sq = F32Lane_Set1(0.0001f*0.0001f);
+  F32Lane target_x = F32Lane_Set1(target.x);
+  F32Lane target_y = F32Lane_Set1(target.y);
+  F32Lane step_lane = F32Lane_Set1(step);
+  for (; (idx + F32Lane_Width) <= count; idx += F32Lane_Width)
+  {
+    F32Lane to_x = F32Lane_Sub(target_x, F32Lane_Load(x + idx));
+    F32Lane to_y = F32Lane_Sub(target_y, F32Lane_Load(y + idx));
+    F32Lane length_sq = F32Lane_Add(F32Lane_Mul(to_x, to_x), F32Lane_Mul(to_y, to_y));
+    F32Lane inv_length = F32Lane_And(f32_lane_rsqrt_fast(length_sq), F32Lane_GreaterThan(length_sq, tolerance_sq));
+    F32Lane_Store(dest_x + idx, F32Lane_Mul(F32Lane_Mul(to_x, inv_length), step_lane));
+    F32Lane_Store(dest_y + idx, F32Lane_Mul(F32Lane_Mul(to_y, inv_length), step_lane));
+  }
+#endif
+  for (; idx < count; ++idx)
+  {
+    v3f to_target = v3f_sub_and_normalize_or_zero_fast(v3f_make(target.x, target.y, 0.0f), v3f_make(x[idx], y[idx], 0.0f));
+    dest_x[idx] = to_target.x * step;
+    dest_y[idx] = to_target.y * step;
+  }
+}
@@ -2,24 +2,37 @@
 #define PCG32_DEFAULT_INCREMENT  1442695040888963407ULL
 
 function inline void
-prng32_seed(PRNG32 *rng, u64 seed)
+prng32_seed_stream(PRNG32 *rng, u64 seed, u64 stream)
 {
   rng->state = 0;
+  rng->inc = (stream << 1) | 1;
   prng32_nextu32(rng);
   rng->state += seed;
   prng32_nextu32(rng);
 }
 
+function inline void
+prng32_seed(PRNG32 *rng, u64 seed)
+{
+  prng32_seed_stream(rng, seed, PCG32_DEFAULT_INCREMENT >> 1);
+}
+
 function inline u32
-prng32_nextu32(PRNG32 *rng)
+prng32_output(u64 state)
 {
-  u64 state = rng->state;
-  rng->state = state * PCG32_DEFAULT_MULTIPLIER + PCG32_DEFAULT_INCREMENT;
   u32 value = (u32)((state ^ (state >> 18)) >> 27);
   s32 rot = state >> 59;
   return ROTR32(value, rot);
 }
 
+function inline u32
+prng32_nextu32(PRNG32 *rng)
+{
+  u64 state = rng->state;
+  rng->state = state * PCG32_DEFAULT_MULTIPLIER + rng->inc;
+  return prng32_output(state);
+}
+
 function inline u32
 prng32_rangeu32(PRNG32 *rng, u32 low, u32 high)
 {
@@ -46,4 +59,205 @@ prng32_nextf32(PRNG32 *rng)
 {
   u32 x = prng32_nextu32(rng);
   return (f32)(s32)(x >> 8) * 0x1.0p-24f;
-}
\ No newline at end of file
+}
+
+// NOTE(cj): the LCG step is an affine map, state * mult + plus. Applying it `delta`
+// times is another affine map, which we get by repeated squaring (Brown,
+// "Random Number Generation with Arbitrary Stride").
+function void
+prng32_jump_constants(u64 delta, u64 inc, u64 *jump_mult, u64 *jump_plus)
+{
+  u64 cur_mult = PCG32_DEFAULT_MULTIPLIER;
+  u64 cur_plus = inc;
+  u64 acc_mult = 1;
+  u64 acc_plus = 0;
+  while (delta)
+  {
+    if (delta & 1)
+    {
+      acc_mult *= cur_mult;
+      acc_plus = acc_plus * cur_mult + cur_plus;
+    }
+    cur_plus = (cur_mult + 1) * cur_plus;
+    cur_mult *= cur_mult;
+    delta >>= 1;
+  }
+  
+  *jump_mult = acc_mult;
+  *jump_plus = acc_plus;
+}
+
+function void
+prng32_advance(PRNG32 *rng, u64 delta)
+{
+  u64 jump_mult, jump_plus;
+  prng32_jump_constants(delta, rng->inc, &jump_mult, &jump_plus);
+  rng->state = rng->state * jump_mult + jump_plus;
+}
+
+#define PRNG32_LaneCount 8
+
+#if defined(DR_SIMD_AVX2)
+// NOTE(cj): avx2 has no 64 bit low multiply, build it out of 32x32->64 ones
+inline function __m256i
+prng32_mul_u64x4(__m256i a, __m256i b)
+{
+  __m256i lo = _mm256_mul_epu32(a, b);
+  __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                   _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+  __m256i result = _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+  return(result);
+}
+
+// NOTE(cj): prng32_output for 4 states, the results are in the low 32 bits of each lane
+inline function __m256i
+prng32_output_x4(__m256i state)
+{
+  __m256i low_32 = _mm256_set1_epi64x(0xFFFFFFFF);
+  __m256i value = _mm256_and_si256(_mm256_srli_epi64(_mm256_xor_si256(state, _mm256_srli_epi64(state, 18)), 27), low_32);
+  __m256i rot = _mm256_srli_epi64(state, 59);
+  __m256i rot_left = _mm256_and_si256(_mm256_sub_epi64(_mm256_set1_epi64x(32), rot), _mm256_set1_epi64x(31));
+  __m256i result = _mm256_or_si256(_mm256_srlv_epi64(value, rot), _mm256_and_si256(_mm256_sllv_epi64(value, rot_left), low_32));
+  return(result);
+}
+#endif
+
+function void
+prng32_fill_u32(PRNG32 *rng, u32 *dest, u64 count)
+{
+  u64 idx = 0;
+  if (count >= PRNG32_LaneCount)
+  {
+    // NOTE(cj): lane i starts i steps ahead and every lane steps lane_count at a
+    // time, so lane i produces elements i, i + lane_count, ... of the sequential
+    // stream
+    u64 lane_mult, lane_plus;
+    prng32_jump_constants(1, rng->inc, &lane_mult, &lane_plus);
+
+#if defined(DR_SIMD_AVX2)
+    u64 lanes[PRNG32_LaneCount];
+    lanes[0] = rng->state;
+    for (u64 lane = 1; lane < PRNG32_LaneCount; ++lane)
+    {
+      lanes[lane] = lanes[lane - 1] * lane_mult + lane_plus;
+    }
+    
+    u64 step_mult, step_plus;
+    prng32_jump_constants(PRNG32_LaneCount, rng->inc, &step_mult, &step_plus);
+    __m256i state_lo = _mm256_loadu_si256((__m256i *)lanes);
+    __m256i state_hi = _mm256_loadu_si256((__m256i *)(lanes + 4));
+    __m256i mult = _mm256_set1_epi64x((s64)step_mult);
+    __m256i plus = _mm256_set1_epi64x((s64)step_plus);
+    __m256i gather_low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    for (; (idx + PRNG32_LaneCount) <= count; idx += PRNG32_LaneCount)
+    {
+      __m256i out_lo = _mm256_permutevar8x32_epi32(prng32_output_x4(state_lo), gather_low_halves);
+      __m256i out_hi = _mm256_permutevar8x32_epi32(prng32_output_x4(state_hi), gather_low_halves);
+      _mm256_storeu_si256((__m256i *)(dest + idx), _mm256_blend_epi32(out_lo, out_hi, 0xF0));
+      
+      state_lo = _mm256_add_epi64(prng32_mul_u64x4(state_lo, mult), plus);
+      state_hi = _mm256_add_epi64(prng32_mul_u64x4(state_hi, mult), plus);
+    }
+    _mm256_storeu_si256((__m256i *)lanes, state_lo);
+    rng->state = lanes[0];
+#else
+    // NOTE(cj): this is not an sse2 path. sse2 has no 64 bit multiply and no per
+    // lane variable shifts (for the rotate), and building both out of pmuludq and
+    // masks costs more than the scalar imul. So without avx2 it's 4 scalar lanes,
+    // which only buys instruction level parallelism: 4 independent multiply
+    // chains instead of one. They're locals rather than an array so they stay in
+    // registers, an 8 entry array spilled and was slower than the plain loop.
+    u64 step_mult, step_plus;
+    prng32_jump_constants(4, rng->inc, &step_mult, &step_plus);
+    u64 state0 = rng->state;
+    u64 state1 = state0 * lane_mult + lane_plus;
+    u64 state2 = state1 * lane_mult + lane_plus;
+    u64 state3 = state2 * lane_mult + lane_plus;
+    for (; (idx + 4) <= count; idx += 4)
+    {
+      dest[idx + 0] = prng32_output(state0);
+      dest[idx + 1] = prng32_output(state1);
+      dest[idx + 2] = prng32_output(state2);
+      dest[idx + 3] = prng32_output(state3);
+      state0 = state0 * step_mult + step_plus;
+      state1 = state1 * step_mult + step_plus;
+      state2 = state2 * step_mult + step_plus;
+      state3 = state3 * step_mult + step_plus;
+    }
+    rng->state = state0;
+#endif
+  }
+  
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = prng32_nextu32(rng);
+  }
+}
+
+function void
+prng32_fill_f32_01(PRNG32 *rng, f32 *dest, u64 count)
+{
+  u32 *bits = (u32 *)dest;
+  prng32_fill_u32(rng, bits, count);
+  
+  u64 idx = 0;
+#if defined(DR_SIMD_AVX2)
+  __m256 scale = _mm256_set1_ps(0x1.0p-24f);
+  for (; (idx + 8) <= count; idx += 8)
+  {
+    __m256i x = _mm256_srli_epi32(_mm256_loadu_si256((__m256i *)(bits + idx)), 8);
+    _mm256_storeu_ps(dest + idx, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+  }
+#elif defined(DR_SIMD_SSE2)
+  __m128 scale = _mm_set1_ps(0x1.0p-24f);
+  for (; (idx + 4) <= count; idx += 4)
+  {
+    __m128i x = _mm_srli_epi32(_mm_loadu_si128((__m128i *)(bits + idx)), 8);
+    _mm_storeu_ps(dest + idx, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+  }
+#endif
+
+  for (; idx < count; ++idx)
+  {
+    dest[idx] = (f32)(s32)(bits[idx] >> 8) * 0x1.0p-24f;
+  }
+}
+
+// NOTE(cj): Lemire's method rejects some draws, so we don't know up front how many
+// raw values we need. Generate them a block at a time, and at the end put the
+// generator where it would be after exactly the draws that were used.
+function void
+prng32_fill_range_u32(PRNG32 *rng, u32 *dest, u64 count, u32 low, u32 high)
+{
+  u32 bound = high - low;
+  u32 threshold = bound ? (-(s32)bound % bound) : 0;
+  u64 start_state = rng->state;
+  u64 consumed = 0;
+  
+  u32 raw[64];
+  u64 raw_count = 0;
+  u64 raw_at = 0;
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    u64 m;
+    u32 l;
+    do
+    {
+      if (raw_at == raw_count)
+      {
+        raw_count = Min(ArrayCount(raw), Max(count - idx, PRNG32_LaneCount));
+        raw_at = 0;
+        prng32_fill_u32(rng, raw, raw_count);
+      }
+      
+      m = (u64)raw[raw_at++] * (u64)bound;
+      l = (u32)m;
+      consumed += 1;
+    } while (l < threshold);
+    
+    dest[idx] = low + (u32)(m >> 32);
+  }
+  
+  rng->state = start_state;
+  prng32_advance(rng, consumed);
+}
@@ -6,12 +6,27 @@
 typedef struct
 {
   u64 state;
+  u64 inc; // selects the stream, always odd
 } PRNG32;
 
 function inline void prng32_seed(PRNG32 *rng, u64 seed);
+// NOTE(cj): every stream is its own sequence (different increment), so two
+// generators seeded with the same seed but different streams don't overlap.
+function inline void prng32_seed_stream(PRNG32 *rng, u64 seed, u64 stream);
+// NOTE(cj): skips delta outputs in O(log delta). Negative deltas (as u64) go back.
+function void prng32_advance(PRNG32 *rng, u64 delta);
 function inline u32 prng32_nextu32(PRNG32 *rng);
 function inline u32 prng32_rangeu32(PRNG32 *rng, u32 low, u32 high);
 // [0, 1)
 function inline f32 prng32_nextf32(PRNG32 *rng);
 
+// NOTE(cj): bulk generation. These produce exactly the same values (and leave the
+// generator in the same state) as calling the functions above `count` times, they
+// just run several generators side by side to do it (8 with avx2, 4 without).
+function void prng32_fill_u32(PRNG32 *rng, u32 *dest, u64 count);
+// [0, 1)
+function void prng32_fill_f32_01(PRNG32 *rng, f32 *dest, u64 count);
+// [low, high)
+function void prng32_fill_range_u32(PRNG32 *rng, u32 *dest, u64 count, u32 low, u32 high);
+
 #endif //PRNG_H
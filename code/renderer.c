@@ -578,7 +578,7 @@ dx11_create_font_atlas(R_State *state, R_InputForRendering *renderer)
     bitmap_info.bmiHeader.biBitCount = 32;
     bitmap_info.bmiHeader.biCompression = BI_RGB;
     
-    Temporary_Memory temp_mem = begin_temporary_memory(get_transient_arena(0,0));
+    Temporary_Memory temp_mem = scratch_begin(0, 0);
     u64 bitmap_area = bitmap_width*bitmap_height*4;
     u8 *source_buffer = m_arena_push(temp_mem.arena, bitmap_area);
     u8 *dest_buffer = m_arena_push(temp_mem.arena, bitmap_area);
@@ -637,7 +637,7 @@ dx11_create_font_atlas(R_State *state, R_InputForRendering *renderer)
       Assert(!"Log Soon");
     }
     
-    end_temporary_memory(temp_mem);
+    scratch_end(temp_mem);
     DeleteObject(bitmap);
     DeleteDC(dc);
   }
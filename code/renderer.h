@@ -93,6 +93,7 @@ typedef struct
   R_Texture2D font_sheet;
 } R_InputForRendering;
 
+#if !defined(DR_HEADLESS)
 typedef struct
 {
   // D3D11 STUFF
@@ -141,5 +142,6 @@ typedef struct
 
 function void r_init(R_State *state, OS_Window window, M_Arena *arena);
 function void r_submit_and_reset(R_State *state, v3f camera_p);
+#endif
 
 #endif //RENDERER_H
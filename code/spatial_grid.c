@@ -0,0 +1,298 @@
+function void
+spatial_grid_init(Spatial_Grid *grid, M_Arena *arena, f32 cell_size)
+{
+  Assert(cell_size > 0.0f);
+  ClearStructP(grid);
+  grid->arena = arena;
+  grid->cell_size = cell_size;
+  grid->inv_cell_size = 1.0f / cell_size;
+}
+
+inline function s32
+spatial_grid_cell_coord(Spatial_Grid *grid, f32 v)
+{
+  s32 result = (s32)floorf(v * grid->inv_cell_size);
+  return(result);
+}
+
+inline function u64
+spatial_grid_cell_key(s32 cell_x, s32 cell_y)
+{
+  u64 result = ((u64)(u32)cell_x << 32) | (u64)(u32)cell_y;
+  return(result);
+}
+
+inline function u32
+spatial_grid_bucket(Spatial_Grid *grid, u64 cell)
+{
+  u32 result = (u32)(hash_u64(cell) & (grid->bucket_count - 1));
+  return(result);
+}
+
+function void
+spatial_grid_reserve(Spatial_Grid *grid, u32 capacity)
+{
+  if (capacity > grid->capacity)
+  {
+    u32 new_capacity = Max(grid->capacity * 2, Max(capacity, 64));
+    
+    grid->items = dr_array_grow(grid->arena, grid->items, sizeof(Spatial_Grid_Item), grid->capacity, new_capacity);
+    grid->pushed_items = dr_array_grow(grid->arena, grid->pushed_items, sizeof(Spatial_Grid_Item), grid->capacity, new_capacity);
+    grid->capacity = new_capacity;
+  }
+}
+
+// NOTE(cj): the bucket count has to be known before pushing (items are bucketed as
+// they come in), so it is sized from the expected count. Pushing more than that
+// still works, the buckets just get longer.
+function void
+spatial_grid_begin(Spatial_Grid *grid, u32 expected_count)
+{
+  grid->count = 0;
+  grid->max_half_dim_x = 0.0f;
+  grid->max_half_dim_y = 0.0f;
+  spatial_grid_reserve(grid, expected_count);
+  
+  u32 bucket_count = SpatialGrid_MinBucketCount;
+  while (bucket_count < expected_count)
+  {
+    bucket_count *= 2;
+  }
+  
+  if (bucket_count + 1 > grid->bucket_capacity)
+  {
+    grid->bucket_start = M_Arena_PushArray(grid->arena, u32, bucket_count + 1);
+    grid->bucket_capacity = bucket_count + 1;
+  }
+  grid->bucket_count = bucket_count;
+  MemoryClear(grid->bucket_start, sizeof(u32) * (bucket_count + 1));
+}
+
+function void
+spatial_grid_push(Spatial_Grid *grid, u32 value, v2f p, v2f half_dims)
+{
+  if (grid->count == grid->capacity)
+  {
+    spatial_grid_reserve(grid, grid->count + 1);
+  }
+  
+  Spatial_Grid_Item *item = grid->pushed_items + grid->count++;
+  item->x = p.x;
+  item->y = p.y;
+  item->half_dim_x = half_dims.x;
+  item->half_dim_y = half_dims.y;
+  item->cell = spatial_grid_cell_key(spatial_grid_cell_coord(grid, p.x), spatial_grid_cell_coord(grid, p.y));
+  item->value = value;
+  item->bucket = spatial_grid_bucket(grid, item->cell);
+  grid->bucket_start[item->bucket + 1] += 1;
+  
+  grid->max_half_dim_x = Max(grid->max_half_dim_x, half_dims.x);
+  grid->max_half_dim_y = Max(grid->max_half_dim_y, half_dims.y);
+}
+
+function void
+spatial_grid_end(Spatial_Grid *grid)
+{
+  // NOTE(cj): bucket_start[b + 1] holds bucket b's count. Prefix sum them into
+  // starts, then scatter, bumping bucket_start[b + 1] as the write cursor. When
+  // that's done bucket_start[b + 1] is where bucket b ends, which is what it
+  // should be.
+  u32 sum = 0;
+  for (u32 bucket = 0; bucket < grid->bucket_count; ++bucket)
+  {
+    u32 bucket_count = grid->bucket_start[bucket + 1];
+    grid->bucket_start[bucket + 1] = sum;
+    sum += bucket_count;
+  }
+  Assert(sum == grid->count);
+  
+  for (u32 idx = 0; idx < grid->count; ++idx)
+  {
+    Spatial_Grid_Item *item = grid->pushed_items + idx;
+    grid->items[grid->bucket_start[item->bucket + 1]++] = *item;
+  }
+}
+
+typedef struct
+{
+  v2f p;
+  v2f half_dims;
+  f32 radius_sq;
+  b32 by_radius;
+} Spatial_Grid_Query;
+
+inline function b32
+spatial_grid_item_matches(Spatial_Grid_Item *item, Spatial_Grid_Query *query)
+{
+  b32 result;
+  if (query->by_radius)
+  {
+    f32 dx = item->x - query->p.x;
+    f32 dy = item->y - query->p.y;
+    result = ((dx*dx + dy*dy) <= query->radius_sq);
+  }
+  else
+  {
+    result = ((absolute_value_f32(item->x - query->p.x) <= (item->half_dim_x + query->half_dims.x)) &&
+              (absolute_value_f32(item->y - query->p.y) <= (item->half_dim_y + query->half_dims.y)));
+  }
+  return(result);
+}
+
+// NOTE(cj): tests every item in every cell the reach covers, or, when that's more
+// cells than there are buckets, simply every item.
+function u32
+spatial_grid_query(Spatial_Grid *grid, Spatial_Grid_Query *query, v2f reach, u32 *results, u32 max_results)
+{
+  u32 result = 0;
+  s32 cell_x0 = spatial_grid_cell_coord(grid, query->p.x - reach.x);
+  s32 cell_y0 = spatial_grid_cell_coord(grid, query->p.y - reach.y);
+  s32 cell_x1 = spatial_grid_cell_coord(grid, query->p.x + reach.x);
+  s32 cell_y1 = spatial_grid_cell_coord(grid, query->p.y + reach.y);
+  u64 cells_covered = (u64)(cell_x1 - cell_x0 + 1) * (u64)(cell_y1 - cell_y0 + 1);
+  if (cells_covered > grid->bucket_count)
+  {
+    for (u32 idx = 0; idx < grid->count; ++idx)
+    {
+      Spatial_Grid_Item *item = grid->items + idx;
+      if (spatial_grid_item_matches(item, query))
+      {
+        if (result < max_results)
+        {
+          results[result] = item->value;
+        }
+        result += 1;
+      }
+    }
+  }
+  else
+  {
+    for (s32 cell_y = cell_y0; cell_y <= cell_y1; ++cell_y)
+    {
+      for (s32 cell_x = cell_x0; cell_x <= cell_x1; ++cell_x)
+      {
+        u64 cell = spatial_grid_cell_key(cell_x, cell_y);
+        u32 bucket = spatial_grid_bucket(grid, cell);
+        for (u32 idx = grid->bucket_start[bucket]; idx < grid->bucket_start[bucket + 1]; ++idx)
+        {
+          Spatial_Grid_Item *item = grid->items + idx;
+          if ((item->cell == cell) && spatial_grid_item_matches(item, query))
+          {
+            if (result < max_results)
+            {
+              results[result] = item->value;
+            }
+            result += 1;
+          }
+        }
+      }
+    }
+  }
+  return(result);
+}
+
+function u32
+spatial_grid_query_rect(Spatial_Grid *grid, v2f p, v2f half_dims, u32 *results, u32 max_results)
+{
+  u32 result = 0;
+  if (grid->count)
+  {
+    Spatial_Grid_Query query = {0};
+    query.p = p;
+    query.half_dims = half_dims;
+    v2f reach = v2f_make(half_dims.x + grid->max_half_dim_x, half_dims.y + grid->max_half_dim_y);
+    result = spatial_grid_query(grid, &query, reach, results, max_results);
+  }
+  return(result);
+}
+
+function u32
+spatial_grid_query_radius(Spatial_Grid *grid, v2f p, f32 radius, u32 *results, u32 max_results)
+{
+  u32 result = 0;
+  if (grid->count)
+  {
+    Spatial_Grid_Query query = {0};
+    query.p = p;
+    query.radius_sq = radius*radius;
+    query.by_radius = 1;
+    result = spatial_grid_query(grid, &query, v2f_make(radius, radius), results, max_results);
+  }
+  return(result);
+}
+
+// NOTE(cj): keeps results sorted by distance. When they're full, the farthest one
+// drops off the end, callers only insert items closer than it.
+inline function void
+spatial_grid_nearest_consider(Spatial_Grid_Item *item, v2f p, f32 radius_sq, u32 skip_value,
+                              Spatial_Grid_Neighbor *results, u32 max_results, u32 *result_count)
+{
+  f32 dx = item->x - p.x;
+  f32 dy = item->y - p.y;
+  f32 distance_sq = dx*dx + dy*dy;
+  u32 count = *result_count;
+  if ((item->value != skip_value) && (distance_sq <= radius_sq) &&
+      ((count < max_results) || (distance_sq < results[max_results - 1].distance_sq)))
+  {
+    u32 idx = count;
+    if (count < max_results)
+    {
+      *result_count = count + 1;
+    }
+    else
+    {
+      idx = max_results - 1;
+    }
+    
+    while ((idx > 0) && (results[idx - 1].distance_sq > distance_sq))
+    {
+      results[idx] = results[idx - 1];
+      --idx;
+    }
+    results[idx].value = item->value;
+    results[idx].distance_sq = distance_sq;
+    results[idx].p = v2f_make(item->x, item->y);
+  }
+}
+
+function u32
+spatial_grid_query_nearest(Spatial_Grid *grid, v2f p, f32 radius, u32 skip_value, Spatial_Grid_Neighbor *results, u32 max_results)
+{
+  u32 result = 0;
+  if (grid->count && max_results)
+  {
+    f32 radius_sq = radius*radius;
+    s32 cell_x0 = spatial_grid_cell_coord(grid, p.x - radius);
+    s32 cell_y0 = spatial_grid_cell_coord(grid, p.y - radius);
+    s32 cell_x1 = spatial_grid_cell_coord(grid, p.x + radius);
+    s32 cell_y1 = spatial_grid_cell_coord(grid, p.y + radius);
+    u64 cells_covered = (u64)(cell_x1 - cell_x0 + 1) * (u64)(cell_y1 - cell_y0 + 1);
+    if (cells_covered > grid->bucket_count)
+    {
+      for (u32 idx = 0; idx < grid->count; ++idx)
+      {
+        spatial_grid_nearest_consider(grid->items + idx, p, radius_sq, skip_value, results, max_results, &result);
+      }
+    }
+    else
+    {
+      for (s32 cell_y = cell_y0; cell_y <= cell_y1; ++cell_y)
+      {
+        for (s32 cell_x = cell_x0; cell_x <= cell_x1; ++cell_x)
+        {
+          u64 cell = spatial_grid_cell_key(cell_x, cell_y);
+          u32 bucket = spatial_grid_bucket(grid, cell);
+          for (u32 idx = grid->bucket_start[bucket]; idx < grid->bucket_start[bucket + 1]; ++idx)
+          {
+            Spatial_Grid_Item *item = grid->items + idx;
+            if (item->cell == cell)
+            {
+              spatial_grid_nearest_consider(item, p, radius_sq, skip_value, results, max_results, &result);
+            }
+          }
+        }
+      }
+    }
+  }
+  return(result);
+}
@@ -0,0 +1,83 @@
+/* date = October 17th 2026 2:40 pm */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+//
+// NOTE(cj): Uniform grid broadphase, hashed so the world has no bounds.
+// Items are axis aligned boxes on the XY plane carrying a u32 value (an entity
+// handle, an index into some array, ...). An item goes in the cell its center
+// falls in; queries grow their range by the biggest item half dims seen, so boxes
+// that stick out of their cell are still found.
+//
+// The grid is rebuilt from scratch: spatial_grid_begin, spatial_grid_push for
+// every item, spatial_grid_end. End counting-sorts the items by bucket, so
+// everything in a bucket is contiguous and a query reads a few short runs.
+// Cells that hash to the same bucket share it, queries check each item's cell.
+//
+// bench_spatial_grid_query ("tests bench"), entity sized items at the same
+// density, ns per item built and per query, next to a rect query that scans
+// every item:
+//       items   build    rect  radius  nearest      scan
+//         100    10.6    64.5    53.2     46.1     117.7
+//        1000    11.8   214.9   164.2    172.6    1620.7
+//       10000    15.0   223.1   164.1    166.9   11144.0
+//      100000    20.1   281.1   185.4    180.1   97563.2
+//
+#define SpatialGrid_MinBucketCount 16
+
+// NOTE(cj): a query reads every field of the items it visits, so items are kept
+// together rather than split into arrays
+typedef struct
+{
+  f32 x, y;
+  f32 half_dim_x, half_dim_y;
+  u64 cell;
+  u32 value;
+  u32 bucket;
+} Spatial_Grid_Item;
+
+typedef struct
+{
+  u32 value;
+  f32 distance_sq;
+  v2f p;
+} Spatial_Grid_Neighbor;
+
+typedef struct
+{
+  M_Arena *arena;
+  f32 cell_size;
+  f32 inv_cell_size;
+  
+  u32 count;
+  u32 capacity;
+  
+  // NOTE(cj): bucket b holds items [bucket_start[b], bucket_start[b + 1])
+  u32 bucket_count; // power of two
+  u32 bucket_capacity;
+  u32 *bucket_start;
+  
+  Spatial_Grid_Item *items;        // sorted by bucket after spatial_grid_end
+  Spatial_Grid_Item *pushed_items; // in push order
+  
+  f32 max_half_dim_x;
+  f32 max_half_dim_y;
+} Spatial_Grid;
+
+function void spatial_grid_init(Spatial_Grid *grid, M_Arena *arena, f32 cell_size);
+function void spatial_grid_begin(Spatial_Grid *grid, u32 expected_count);
+function void spatial_grid_push(Spatial_Grid *grid, u32 value, v2f p, v2f half_dims);
+function void spatial_grid_end(Spatial_Grid *grid);
+
+// NOTE(cj): queries write up to max_results values and return how many items
+// matched, which can be more than max_results.
+// rect: items whose box overlaps the rect.
+// radius: items whose center is within radius of p.
+function u32 spatial_grid_query_rect(Spatial_Grid *grid, v2f p, v2f half_dims, u32 *results, u32 max_results);
+function u32 spatial_grid_query_radius(Spatial_Grid *grid, v2f p, f32 radius, u32 *results, u32 max_results);
+// nearest: up to max_results items whose center is within radius of p, closest
+// first, skipping the item whose value is skip_value. Returns how many it wrote.
+function u32 spatial_grid_query_nearest(Spatial_Grid *grid, v2f p, f32 radius, u32 skip_value, Spatial_Grid_Neighbor *results, u32 max_results);
+
+#endif //SPATIAL_GRID_H
@@ -0,0 +1,4063 @@
+//
+// NOTE(cj): Tests and benchmarks for the platform independent code (base,
+// containers, prng, math, ...). This is its own program: build.bat builds it next
+// to the game, build.sh builds it on linux. Without arguments it runs the checks
+// and returns nonzero if any of them failed. "tests bench" runs the benchmarks
+// after the checks. Both scripts also build it as tests_avx2 with avx2 enabled,
+// which is the only build that has the avx2 paths in it.
+//
+#if defined(_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#endif
+
+// NOTE(cj): no window or renderer here, only the platform independent parts of
+// their headers (the input and quad types the UI is built on)
+#define DR_HEADLESS
+
+#include "base.h"
+#include "containers.h"
+#include "windows_stuff.h"
+#include "prng.h"
+#include "mathematical_objects.h"
+#include "spatial_grid.h"
+#include "flow_field.h"
+#include "experience_gems.h"
+#include "renderer.h"
+#include "ui.h"
+#include "game.h"
+
+#include "base.c"
+#include "containers.c"
+#include "mathematical_objects.c"
+#include "spatial_grid.c"
+#include "flow_field.c"
+#include "experience_gems.c"
+#include "entities.c"
+#include "prng.c"
+#include "ui.c"
+
+#include <stdlib.h>
+#if defined(OS_POSIX)
+# include <time.h>
+# include <pthread.h>
+#endif
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/syscall.h>
+#endif
+
+global_variable u64 g_test_check_count;
+global_variable u64 g_test_failure_count;
+
+// NOTE(cj): results of benchmark loops go here, so the optimizer can't drop them
+global_variable volatile u64 g_bench_sink;
+
+#define TestCheck(c) test_check(!!(c), #c, __FILE__, __LINE__)
+
+function void
+test_check(b32 ok, char *expression, char *file, int line)
+{
+  g_test_check_count += 1;
+  if (!ok)
+  {
+    g_test_failure_count += 1;
+    printf("%s(%d): check failed: %s\n", file, line, expression);
+  }
+}
+
+function f64
+test_seconds(void)
+{
+  f64 result;
+#if defined(OS_WINDOWS)
+  LARGE_INTEGER counter, frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  result = (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  result = (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+#endif
+  return(result);
+}
+
+//
+// NOTE(cj): Hardware event counters, for the benchmarks that care about the TLB.
+// Only linux lets a normal process read them. Everywhere else (or when the kernel
+// says no) the counter reads as unavailable.
+//
+typedef struct
+{
+  int fd;
+} Test_Counter;
+
+function Test_Counter
+test_counter_begin_dtlb_misses(void)
+{
+  Test_Counter result = { -1 };
+#if defined(__linux__)
+  struct perf_event_attr attr;
+  MemoryClear(&attr, sizeof(attr));
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.size = sizeof(attr);
+  attr.config = (PERF_COUNT_HW_CACHE_DTLB |
+                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  result.fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  return(result);
+}
+
+// NOTE(cj): returns InvalidIndexU64 when the counter is unavailable
+function u64
+test_counter_end(Test_Counter counter)
+{
+  u64 result = InvalidIndexU64;
+#if defined(__linux__)
+  if (counter.fd >= 0)
+  {
+    u64 value;
+    if (read(counter.fd, &value, sizeof(value)) == sizeof(value))
+    {
+      result = value;
+    }
+    close(counter.fd);
+  }
+#else
+  (void)counter;
+#endif
+  return(result);
+}
+
+//
+// NOTE(cj): M_Arena, os backend
+//
+function void
+test_arena_os(void)
+{
+  M_Arena_Flag flag_sets[] = { 0, M_ArenaFlag_LargePages };
+  for (u64 flag_idx = 0; flag_idx < ArrayCount(flag_sets); ++flag_idx)
+  {
+    M_Arena *arena = m_arena_reserve_flags(MB(8), flag_sets[flag_idx]);
+    TestCheck(arena);
+    if (arena)
+    {
+      if (flag_sets[flag_idx] & M_ArenaFlag_LargePages)
+      {
+        TestCheck(((u64)arena->base % M_Arena_LargePageSize) == 0);
+      }
+      
+      // NOTE(cj): every byte we get must be writable, and pop has to hand back
+      // exactly what push gave
+      u64 start_pos = m_arena_pos(arena);
+      u8 *first = m_arena_push(arena, MB(3));
+      memset(first, 0xAB, MB(3));
+      u8 *second = m_arena_push(arena, 100);
+      TestCheck(second == first + MB(3));
+      TestCheck(((u64)second % 16) == 0);
+      memset(second, 0xCD, 100);
+      TestCheck((first[0] == 0xAB) && (first[MB(3) - 1] == 0xAB));
+      
+      m_arena_pop(arena, 100);
+      m_arena_pop(arena, MB(3));
+      TestCheck(m_arena_pos(arena) == start_pos);
+      
+      // NOTE(cj): pages that went back to the os come back zeroed
+      u8 *again = m_arena_push(arena, MB(3));
+      TestCheck(again == first);
+      memset(again, 0x11, MB(3));
+      m_arena_release(arena);
+    }
+  }
+}
+
+function void
+test_arena_decommit_hysteresis(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(8));
+  m_arena_set_decommit_hysteresis(arena, 4, 0);
+  u64 idle_commit_ptr = arena->commit_ptr;
+  
+  // NOTE(cj): a burst, then idle frames. The memory stays committed until the
+  // arena has been idle for the whole window, which starts after the frame of
+  // the burst ended.
+  u64 pos = m_arena_pos(arena);
+  memset(m_arena_push(arena, MB(2)), 1, MB(2));
+  m_arena_pop_to(arena, pos);
+  u64 burst_commit_ptr = arena->commit_ptr;
+  TestCheck(burst_commit_ptr > MB(2));
+  for (u32 frame = 0; frame < 4; ++frame)
+  {
+    m_arena_end_frame(arena);
+    TestCheck(arena->commit_ptr == burst_commit_ptr);
+  }
+  m_arena_end_frame(arena);
+  TestCheck(arena->commit_ptr == idle_commit_ptr);
+  TestCheck(arena->stats.decommit_count == 1);
+  
+  // NOTE(cj): a burst every other frame keeps the window from ever completing
+  for (u32 frame = 0; frame < 16; ++frame)
+  {
+    if (frame & 1)
+    {
+      m_arena_push(arena, MB(1));
+      m_arena_pop_to(arena, pos);
+    }
+    m_arena_end_frame(arena);
+  }
+  TestCheck(arena->stats.decommit_count == 1);
+  m_arena_release(arena);
+  
+  // NOTE(cj): without real large pages the arena falls back to 4KB pages, and
+  // that has to start out with hysteresis instead of decommitting 2MB at a time
+  M_Arena *large = m_arena_reserve_flags(MB(8), M_ArenaFlag_LargePages);
+  if (large->flags & M_ArenaFlag_NoDecommit)
+  {
+    TestCheck(large->decommit_after_frames == 0);
+  }
+  else
+  {
+    TestCheck(large->decommit_after_frames == M_Arena_LargePageDecommitFrames);
+    pos = m_arena_pos(large);
+    m_arena_push(large, MB(3));
+    m_arena_pop_to(large, pos);
+    m_arena_end_frame(large);
+    TestCheck(large->stats.decommit_count == 0);
+  }
+  m_arena_release(large);
+  
+  // NOTE(cj): asking for NoDecommit ourselves still commits on demand
+  M_Arena *no_decommit = m_arena_reserve_flags(MB(4), M_ArenaFlag_NoDecommit);
+  TestCheck(no_decommit->commit_ptr < no_decommit->capacity);
+  pos = m_arena_pos(no_decommit);
+  memset(m_arena_push(no_decommit, MB(3)), 1, MB(3));
+  m_arena_pop_to(no_decommit, pos);
+  TestCheck(no_decommit->stats.decommit_count == 0);
+  m_arena_release(no_decommit);
+}
+
+function void
+test_arena_telemetry(void)
+{
+  M_Arena *arena = m_arena_reserve_flags(KB(256), M_ArenaFlag_Chained);
+  m_arena_set_name(arena, str8("telemetry test"));
+  b32 registered = 0;
+  for (u64 index = 0; index < m_arena_registered_count(); ++index)
+  {
+    registered |= (m_arena_registered(index) == arena);
+  }
+  TestCheck(registered);
+  
+  u64 pos = m_arena_pos(arena);
+  m_arena_push(arena, 1000);
+  m_arena_push(arena, 3000);
+  M_Arena_Telemetry telemetry = m_arena_get_telemetry(arena);
+  TestCheck(telemetry.current_bytes == 1008 + 3008);
+  TestCheck(telemetry.peak_bytes == 1008 + 3008);
+#if defined(DR_ARENA_TELEMETRY)
+  TestCheck(telemetry.push_count == 2);
+  TestCheck(telemetry.largest_push == 3008);
+#else
+  TestCheck((telemetry.push_count == 0) && (telemetry.largest_push == 0));
+#endif
+
+  // NOTE(cj): the peak has to survive the pop, and the stats must not depend on
+  // whether anybody popped in between
+  m_arena_pop_to(arena, pos);
+  m_arena_push(arena, 16);
+  telemetry = m_arena_get_telemetry(arena);
+  TestCheck(telemetry.current_bytes == 16);
+  TestCheck(telemetry.peak_bytes == 1008 + 3008);
+  
+  // NOTE(cj): end of frame folds the frame's peak into the stats, and the next
+  // frame starts over from where the stack is
+  m_arena_end_frame(arena);
+  TestCheck(arena->stats.peak_stack_ptr == M_Arena_HeaderSize + 1008 + 3008);
+  TestCheck(arena->frame_high_water_ptr == M_Arena_HeaderSize + 16);
+  m_arena_push(arena, 5000);
+  m_arena_pop(arena, 5000);
+  m_arena_end_frame(arena);
+  TestCheck(m_arena_get_telemetry(arena).peak_bytes == 16 + 5008);
+  
+  // NOTE(cj): chained arenas add up their blocks
+  m_arena_push(arena, KB(200));
+  m_arena_push(arena, KB(200));
+  TestCheck(arena->current != arena);
+  telemetry = m_arena_get_telemetry(arena);
+  TestCheck(telemetry.current_bytes == 16 + KB(400));
+  TestCheck(telemetry.reserved_bytes == 2*KB(256));
+  m_arena_release(arena);
+  
+  // NOTE(cj): released arenas must not stay in the registry
+  for (u64 index = 0; index < m_arena_registered_count(); ++index)
+  {
+    TestCheck(m_arena_registered(index) != arena);
+  }
+}
+
+function void
+test_arena_chained_pop(void)
+{
+  // NOTE(cj): 4 blocks of 64KB, each push fills most of one, so every push after
+  // the first starts a new block
+  M_Arena *arena = m_arena_reserve_flags(KB(64), M_ArenaFlag_Chained);
+  u64 start_pos = m_arena_pos(arena);
+  u64 push_size = KB(48);
+  u8 *pushes[4];
+  u64 positions[4];
+  for (u64 push_idx = 0; push_idx < ArrayCount(pushes); ++push_idx)
+  {
+    pushes[push_idx] = m_arena_push(arena, push_size);
+    memset(pushes[push_idx], (int)push_idx, push_size);
+    positions[push_idx] = m_arena_pos(arena);
+  }
+  TestCheck(arena->current->prev && arena->current->prev->prev && arena->current->prev->prev->prev == arena);
+  
+  // NOTE(cj): popping one push at a time must land on the same positions the
+  // pushes left behind
+  m_arena_pop(arena, push_size);
+  TestCheck(m_arena_pos(arena) == positions[2]);
+  m_arena_pop(arena, 2*push_size);
+  TestCheck(m_arena_pos(arena) == positions[0]);
+  TestCheck(pushes[0][push_size - 1] == 0);
+  m_arena_pop(arena, push_size);
+  TestCheck(m_arena_pos(arena) == start_pos);
+  TestCheck(arena->current == arena);
+  
+  // NOTE(cj): a pop that ends in the middle of an earlier block
+  m_arena_push(arena, push_size);
+  u64 pos_mid = m_arena_pos(arena) - KB(16);
+  m_arena_push(arena, push_size);
+  m_arena_push(arena, push_size);
+  m_arena_pop(arena, 2*push_size + KB(16));
+  TestCheck(m_arena_pos(arena) == pos_mid);
+  TestCheck(arena->current == arena);
+  
+  // NOTE(cj): pushing again after that reuses the spare block
+  M_Arena *spare = arena->spare;
+  TestCheck(spare != 0);
+  m_arena_push(arena, push_size);
+  TestCheck(arena->current == spare);
+  
+  // NOTE(cj): m_arena_grow falls back to a copy when the extension doesn't fit
+  u8 *grown = m_arena_push(arena, KB(8));
+  memset(grown, 7, KB(8));
+  u8 *moved = m_arena_grow(arena, grown, KB(8), KB(40));
+  TestCheck(moved != grown);
+  TestCheck(moved[0] == 7 && moved[KB(8) - 1] == 7);
+  m_arena_release(arena);
+}
+
+// NOTE(cj): the arena before chaining, hysteresis and stats, to check the push
+// and pop hot paths didn't get slower for the common single block case
+typedef struct
+{
+  u8 *base;
+  u64 commit_ptr;
+  u64 stack_ptr;
+  u64 capacity;
+} Bench_BaselineArena;
+
+function void *
+bench_baseline_arena_push(Bench_BaselineArena *arena, u64 push_size)
+{
+  void *result_block = 0;
+  push_size = AlignAToB(push_size, 16);
+  u64 desired_stack_ptr = arena->stack_ptr + push_size;
+  u64 desired_commit_ptr = arena->commit_ptr;
+  if (desired_stack_ptr <= arena->capacity)
+  {
+    if (desired_stack_ptr >= arena->commit_ptr)
+    {
+      u64 new_commit_ptr = AlignAToB(desired_stack_ptr, M_Arena_DefaultCommit);
+      u64 new_commit_ptr_clamped = Min(new_commit_ptr, arena->capacity);
+      if (new_commit_ptr_clamped > arena->commit_ptr)
+      {
+        m_os_commit(arena->base + arena->commit_ptr, new_commit_ptr_clamped - arena->commit_ptr);
+        desired_commit_ptr = new_commit_ptr_clamped;
+      }
+    }
+    
+    if (desired_commit_ptr > desired_stack_ptr)
+    {
+      result_block = arena->base + arena->stack_ptr;
+      arena->stack_ptr = desired_stack_ptr;
+      arena->commit_ptr = desired_commit_ptr;
+    }
+  }
+  return(result_block);
+}
+
+function void
+bench_baseline_arena_pop(Bench_BaselineArena *arena, u64 pop_size)
+{
+  pop_size = AlignAToB(pop_size, 16);
+  arena->stack_ptr -= pop_size;
+  u64 new_commit_ptr = AlignAToB(arena->stack_ptr, M_Arena_DefaultCommit);
+  if (new_commit_ptr < arena->commit_ptr)
+  {
+    m_os_decommit(arena->base + new_commit_ptr, arena->commit_ptr - new_commit_ptr);
+    arena->commit_ptr = new_commit_ptr;
+  }
+}
+
+function void
+bench_arena_push_pop(void)
+{
+  printf("\n== arena push/pop, single block: 64 pushes of 16..1024 bytes, then the pops (best of 5 x 100000)\n");
+  printf("%-24s %12s\n", "", "ns per op");
+  
+  u64 round_count = 100000;
+  u64 sizes[64];
+  for (u64 size_idx = 0; size_idx < ArrayCount(sizes); ++size_idx)
+  {
+    sizes[size_idx] = 16 + (size_idx*37 % 1009);
+  }
+  
+  // NOTE(cj): like the real one, the header lives at the start of its memory
+  u8 *baseline_memory = m_os_reserve(MB(8), 0);
+  m_os_commit(baseline_memory, M_Arena_DefaultCommit);
+  Bench_BaselineArena *baseline = (Bench_BaselineArena *)baseline_memory;
+  baseline->base = baseline_memory;
+  baseline->capacity = MB(8);
+  baseline->commit_ptr = M_Arena_DefaultCommit;
+  baseline->stack_ptr = AlignAToB(sizeof(Bench_BaselineArena), 16);
+  M_Arena *arena = m_arena_reserve(MB(8));
+  M_Arena *chained = m_arena_reserve_flags(MB(8), M_ArenaFlag_Chained);
+  
+  // NOTE(cj): everything goes through a pointer so nothing gets inlined into the
+  // loop. The game calls these from all over the place, where they aren't either.
+  void *(* volatile baseline_push)(Bench_BaselineArena *, u64) = bench_baseline_arena_push;
+  void (* volatile baseline_pop)(Bench_BaselineArena *, u64) = bench_baseline_arena_pop;
+  void *(* volatile arena_push)(M_Arena *, u64) = m_arena_push;
+  void (* volatile arena_pop)(M_Arena *, u64) = m_arena_pop;
+  
+  f64 best_secs[3] = { 1e9, 1e9, 1e9 };
+  u64 sum = 0;
+  for (u32 run = 0; run < 5; ++run)
+  {
+    f64 start = test_seconds();
+    for (u64 round = 0; round < round_count; ++round)
+    {
+      for (u64 size_idx = 0; size_idx < ArrayCount(sizes); ++size_idx)
+      {
+        sum += (u64)baseline_push(baseline, sizes[size_idx]);
+      }
+      for (u64 size_idx = ArrayCount(sizes); size_idx-- > 0;)
+      {
+        baseline_pop(baseline, sizes[size_idx]);
+      }
+    }
+    best_secs[0] = Min(best_secs[0], test_seconds() - start);
+    
+    M_Arena *arenas[] = { arena, chained };
+    for (u64 arena_idx = 0; arena_idx < ArrayCount(arenas); ++arena_idx)
+    {
+      start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        for (u64 size_idx = 0; size_idx < ArrayCount(sizes); ++size_idx)
+        {
+          sum += (u64)arena_push(arenas[arena_idx], sizes[size_idx]);
+        }
+        for (u64 size_idx = ArrayCount(sizes); size_idx-- > 0;)
+        {
+          arena_pop(arenas[arena_idx], sizes[size_idx]);
+        }
+      }
+      best_secs[1 + arena_idx] = Min(best_secs[1 + arena_idx], test_seconds() - start);
+    }
+  }
+  g_bench_sink += sum;
+  m_os_release(baseline_memory, MB(8));
+  m_arena_release(arena);
+  m_arena_release(chained);
+  
+  f64 op_count = (f64)(round_count*2*ArrayCount(sizes));
+  printf("%-24s %12.2f\n", "baseline arena", best_secs[0] / op_count * 1e9);
+  printf("%-24s %12.2f\n", "M_Arena", best_secs[1] / op_count * 1e9);
+  printf("%-24s %12.2f\n", "M_Arena, chained", best_secs[2] / op_count * 1e9);
+}
+
+//
+// NOTE(cj): Containers
+//
+DefineDynamicArray(u64, u64);
+DefineHashMapU64(u64, u64);
+
+function void
+test_dynamic_array(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(8));
+  u64_Array arr;
+  u64_array_init(&arr, arena, 4);
+  
+  // NOTE(cj): as long as nothing else is pushed the array grows in place
+  u64 *first_storage = arr.v;
+  for (u64 value = 0; value < 1000; ++value)
+  {
+    *u64_array_push(&arr) = value;
+  }
+  TestCheck(arr.count == 1000);
+  TestCheck(arr.capacity >= 1000);
+  TestCheck(arr.v == first_storage);
+  
+  // NOTE(cj): once something else sits on top it has to move, and keep its values
+  m_arena_push(arena, 16);
+  u64_array_reserve(&arr, arr.capacity + 1);
+  TestCheck(arr.v != first_storage);
+  b32 values_kept = 1;
+  for (u64 value = 0; value < 1000; ++value)
+  {
+    values_kept &= (arr.v[value] == value);
+  }
+  TestCheck(values_kept);
+  
+  u64_array_swap_remove(&arr, 10);
+  TestCheck(arr.count == 999);
+  TestCheck(arr.v[10] == 999);
+  u64_array_swap_remove(&arr, arr.count - 1);
+  TestCheck(arr.count == 998);
+  TestCheck(arr.v[arr.count - 1] == 997);
+  m_arena_release(arena);
+}
+
+function void
+test_hash_map(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(64));
+  HashMap_U64 map;
+  u64_map_init(&map, arena, 0);
+  
+  // NOTE(cj): random inserts, removes and finds against a plain array that says
+  // what should be in the map. Small keys, so the same keys come up again and
+  // tombstones get reused.
+  u64 key_range = 4096;
+  u64 *reference = M_Arena_PushArray(arena, u64, key_range);
+  u8 *present = M_Arena_PushArray(arena, u8, key_range);
+  MemoryClear(present, key_range);
+  u64 present_count = 0;
+  b32 all_agreed = 1;
+  PRNG32 rng;
+  prng32_seed(&rng, 7);
+  for (u64 op_idx = 0; op_idx < 200000; ++op_idx)
+  {
+    u64 key = prng32_rangeu32(&rng, 0, (u32)key_range);
+    u32 op = prng32_rangeu32(&rng, 0, 3);
+    if (op == 0)
+    {
+      b32 was_present = 0;
+      u64 *value = hash_map_u64_insert(&map, key, &was_present);
+      all_agreed &= (was_present == present[key]);
+      *value = op_idx;
+      reference[key] = op_idx;
+      present_count += !present[key];
+      present[key] = 1;
+    }
+    else if (op == 1)
+    {
+      all_agreed &= (u64_map_remove(&map, key) == present[key]);
+      present_count -= present[key];
+      present[key] = 0;
+    }
+    else
+    {
+      u64 *value = u64_map_find(&map, key);
+      all_agreed &= ((value != 0) == present[key]);
+      all_agreed &= (!value || (*value == reference[key]));
+    }
+    all_agreed &= (map.count == present_count);
+  }
+  TestCheck(all_agreed);
+  
+  // NOTE(cj): iteration visits every key once
+  u64 cursor = 0;
+  u64 key = 0;
+  u64 visited = 0;
+  b32 iteration_agreed = 1;
+  for (u64 *value = hash_map_u64_next(&map, &cursor, &key); value; value = hash_map_u64_next(&map, &cursor, &key))
+  {
+    iteration_agreed &= present[key] && (*value == reference[key]);
+    visited += 1;
+  }
+  TestCheck(iteration_agreed);
+  TestCheck(visited == present_count);
+  
+  // NOTE(cj): keys that hash close together, and growth from empty
+  HashMap_U64 big;
+  u64_map_init(&big, arena, 0);
+  for (u64 key_idx = 0; key_idx < 100000; ++key_idx)
+  {
+    u64_map_insert(&big, key_idx << 32, key_idx);
+  }
+  b32 big_found = 1;
+  for (u64 key_idx = 0; key_idx < 100000; ++key_idx)
+  {
+    u64 *value = u64_map_find(&big, key_idx << 32);
+    big_found &= value && (*value == key_idx);
+  }
+  TestCheck(big_found);
+  TestCheck(u64_map_find(&big, 1) == 0);
+  TestCheck(big.count == 100000);
+  
+  hash_map_u64_clear(&big);
+  TestCheck(big.count == 0);
+  TestCheck(u64_map_find(&big, 5llu << 32) == 0);
+  
+  // NOTE(cj): a map that stays the same size but keeps replacing its keys fills
+  // up with tombstones. Clearing them out must not push a new table every time.
+  HashMap_U64 churn;
+  u64_map_init(&churn, arena, 64);
+  for (u64 key_idx = 0; key_idx < 24; ++key_idx)
+  {
+    u64_map_insert(&churn, key_idx, key_idx);
+  }
+  u64 churn_capacity = churn.capacity;
+  u64 churn_pos = m_arena_pos(arena);
+  b32 churn_agreed = 1;
+  for (u64 key_idx = 24; key_idx < 100000; ++key_idx)
+  {
+    churn_agreed &= u64_map_remove(&churn, key_idx - 24);
+    u64_map_insert(&churn, key_idx, key_idx);
+    churn_agreed &= (churn.tombstones + churn.count)*8 <= churn.capacity*7;
+  }
+  for (u64 key_idx = 100000 - 24; key_idx < 100000; ++key_idx)
+  {
+    u64 *value = u64_map_find(&churn, key_idx);
+    churn_agreed &= value && (*value == key_idx);
+  }
+  TestCheck(churn_agreed);
+  TestCheck(churn.count == 24);
+  TestCheck(churn.capacity == churn_capacity);
+  TestCheck(m_arena_pos(arena) == churn_pos);
+  m_arena_release(arena);
+}
+
+// NOTE(cj): the widget cache the UI had before the hash map: 128 buckets of
+// linked nodes, looked up by walking the chain
+typedef struct Bench_ChainedNode Bench_ChainedNode;
+struct Bench_ChainedNode
+{
+  u64 key;
+  Bench_ChainedNode *next_in_hash;
+  u64 value;
+};
+#define Bench_ChainedCacheSize 128
+
+function Bench_ChainedNode *
+bench_chained_find(Bench_ChainedNode **cache, u64 key)
+{
+  Bench_ChainedNode *result = cache[key & (Bench_ChainedCacheSize - 1)];
+  while (result && (result->key != key))
+  {
+    result = result->next_in_hash;
+  }
+  return(result);
+}
+
+function void
+bench_hash_map_vs_chained(void)
+{
+  printf("\n== lookups by hashed key: chained 128 bucket cache vs HashMap_U64 (best of 3)\n");
+  printf("%-10s %16s %16s %16s %16s\n", "keys", "chained hit ns", "map hit ns", "chained miss ns", "map miss ns");
+  
+  u64 key_counts[] = { 64, 256, 1024, 4096, 16384 };
+  u64 lookup_count = 4000000;
+  for (u64 count_idx = 0; count_idx < ArrayCount(key_counts); ++count_idx)
+  {
+    u64 key_count = key_counts[count_idx];
+    M_Arena *arena = m_arena_reserve(MB(64));
+    
+    // NOTE(cj): the UI keys are already hashed strings
+    PRNG32 rng;
+    prng32_seed(&rng, 11);
+    u64 *keys = M_Arena_PushArray(arena, u64, key_count);
+    u64 *misses = M_Arena_PushArray(arena, u64, key_count);
+    for (u64 key_idx = 0; key_idx < key_count; ++key_idx)
+    {
+      keys[key_idx] = ((u64)prng32_nextu32(&rng) << 32) | prng32_nextu32(&rng);
+      misses[key_idx] = ((u64)prng32_nextu32(&rng) << 32) | prng32_nextu32(&rng);
+    }
+    u32 *order = M_Arena_PushArray(arena, u32, lookup_count);
+    prng32_fill_range_u32(&rng, order, lookup_count, 0, (u32)key_count);
+    
+    Bench_ChainedNode **cache = M_Arena_PushArray(arena, Bench_ChainedNode *, Bench_ChainedCacheSize);
+    MemoryClear(cache, sizeof(*cache) * Bench_ChainedCacheSize);
+    HashMap_U64 map;
+    u64_map_init(&map, arena, 0);
+    for (u64 key_idx = 0; key_idx < key_count; ++key_idx)
+    {
+      Bench_ChainedNode *node = M_Arena_PushStruct(arena, Bench_ChainedNode);
+      node->key = keys[key_idx];
+      node->value = key_idx;
+      SLLPushFrontN(cache[node->key & (Bench_ChainedCacheSize - 1)], node, next_in_hash);
+      u64_map_insert(&map, keys[key_idx], key_idx);
+    }
+    
+    f64 best_secs[4] = { 1e9, 1e9, 1e9, 1e9 };
+    u64 sum = 0;
+    for (u32 run = 0; run < 3; ++run)
+    {
+      for (u32 miss = 0; miss < 2; ++miss)
+      {
+        u64 *lookup_keys = miss ? misses : keys;
+        f64 start = test_seconds();
+        for (u64 lookup_idx = 0; lookup_idx < lookup_count; ++lookup_idx)
+        {
+          Bench_ChainedNode *node = bench_chained_find(cache, lookup_keys[order[lookup_idx]]);
+          sum += node ? node->value : 1;
+        }
+        best_secs[miss*2 + 0] = Min(best_secs[miss*2 + 0], test_seconds() - start);
+        
+        start = test_seconds();
+        for (u64 lookup_idx = 0; lookup_idx < lookup_count; ++lookup_idx)
+        {
+          u64 *value = u64_map_find(&map, lookup_keys[order[lookup_idx]]);
+          sum += value ? *value : 1;
+        }
+        best_secs[miss*2 + 1] = Min(best_secs[miss*2 + 1], test_seconds() - start);
+      }
+    }
+    g_bench_sink += sum;
+    
+    f64 to_ns = 1e9 / (f64)lookup_count;
+    printf("%-10llu %16.2f %16.2f %16.2f %16.2f\n", (unsigned long long)key_count,
+           best_secs[0]*to_ns, best_secs[1]*to_ns, best_secs[2]*to_ns, best_secs[3]*to_ns);
+    m_arena_release(arena);
+  }
+}
+
+//
+// NOTE(cj): UI identifier interning
+//
+// NOTE(cj): a frame shaped like the HUD sidebar: fixed labels, and labels whose
+// identifier carries a number, which is a new identifier whenever it changes
+function void
+test_ui_frame(UI_Context *ctx, R_UI_QuadArray *quads, u32 wave_number, u32 entity_count, u32 hp)
+{
+  quads->count = 0;
+  ui_begin(ctx, 1280, 720, 1.0f / 60.0f);
+  ui_push_vlayout(ctx, 0.0f, v2f_make(14.0f, 14.0f), v2f_zero(), str8("main-sidebar"));
+  {
+    ui_push_label(ctx, str8("side-label###Player"));
+    ui_push_hlayout(ctx, 0.0f, v2f_zero(), v2f_make(16.0f, 0.0f), str8("player-section"));
+    {
+      ui_push_vlayout(ctx, 0.0f, v2f_zero(), v2f_zero(), str8("player-section-left-side"));
+      {
+        ui_push_label(ctx, str8("Wave:"));
+        ui_push_label(ctx, str8("Enemies Alive:"));
+        ui_push_label(ctx, str8("Health:"));
+      }
+      ui_vlayout_pop(ctx);
+      
+      ui_push_vlayout(ctx, 0.0f, v2f_zero(), v2f_zero(), str8("player-section-right-side"));
+      {
+        ui_push_labelf(ctx, str8("WaveNum###%u"), wave_number);
+        ui_push_labelf(ctx, str8("EntityCount###%u"), entity_count);
+        ui_push_labelf(ctx, str8("player-hp###%u / %u"), hp, 100);
+      }
+      ui_vlayout_pop(ctx);
+    }
+    ui_hlayout_pop(ctx);
+  }
+  ui_vlayout_pop(ctx);
+  ui_end(ctx);
+}
+
+function void
+test_ui_intern(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(4));
+  OS_Input input = {0};
+  R_Font font = {0};
+  R_Texture2D sprite_sheet = {0};
+  R_UI_QuadArray quads = {0};
+  quads.capacity = 1024;
+  quads.quads = M_Arena_PushArray(arena, R_UI_Quad, quads.capacity);
+  UI_Context *ctx = ui_create_context(&input, &quads, font, sprite_sheet);
+  
+  // NOTE(cj): the first frame interns everything, every frame after it that
+  // shows the same thing copies nothing and allocates nothing
+  test_ui_frame(ctx, &quads, 3, 1040, 100);
+  u64 widget_count = ctx->frame_stats.intern_misses;
+  TestCheck(widget_count == 12);
+  TestCheck(ctx->frame_stats.bytes_copied > 0);
+  TestCheck(ctx->frame_stats.arena_bytes_pushed > 0);
+  TestCheck(quads.count > 0);
+  b32 steady = 1;
+  for (u32 frame = 0; frame < 100; ++frame)
+  {
+    test_ui_frame(ctx, &quads, 3, 1040, 100);
+    steady &= (ctx->frame_stats.intern_hits == widget_count);
+    steady &= (ctx->frame_stats.intern_misses == 0);
+    steady &= (ctx->frame_stats.interns_evicted == 0);
+    steady &= (ctx->frame_stats.bytes_copied == 0);
+    steady &= (ctx->frame_stats.arena_bytes_pushed == 0);
+  }
+  TestCheck(steady);
+  
+  // NOTE(cj): a counter that changes every frame evicts and interns a label a
+  // frame. Eviction lags a frame, so the first two frames of churn (with a wave
+  // change, the most labels that change at once) need new entries and buffers.
+  // From then on the freed ones are reused and nothing is allocated, however
+  // long it runs (the intern map's tombstones used to leave a dead table in the
+  // arena every couple hundred frames).
+  test_ui_frame(ctx, &quads, 4, 1041, 99);
+  test_ui_frame(ctx, &quads, 4, 1042, 98);
+  u64 churn_pos = m_arena_pos(ctx->arena);
+  b32 churn_matched = 1;
+  u64 churn_evicted = 0;
+  u64 churn_bytes_copied = 0;
+  for (u32 frame = 0; frame < 20000; ++frame)
+  {
+    test_ui_frame(ctx, &quads, 4 + frame / 1000, 1043 + frame, 97 - (frame % 50));
+    u64 changed_count = 2 + ((frame > 0) && ((frame % 1000) == 0));
+    churn_matched &= (ctx->frame_stats.intern_misses == changed_count);
+    churn_matched &= (ctx->frame_stats.intern_hits == widget_count - changed_count);
+    churn_matched &= (ctx->frame_stats.arena_bytes_pushed == 0);
+    churn_evicted += ctx->frame_stats.interns_evicted;
+    churn_bytes_copied += ctx->frame_stats.bytes_copied;
+  }
+  TestCheck(churn_matched);
+  TestCheck(churn_evicted == 2*20000 + 19);
+  TestCheck(churn_bytes_copied > 0);
+  TestCheck(m_arena_pos(ctx->arena) == churn_pos);
+  
+  m_arena_release(ctx->arena);
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): String search
+//
+// NOTE(cj): the scalar versions from before the SIMD paths, as the reference and
+// the baseline for the bench
+function b32
+test_reference_str8_equal_strings(String_U8_Const a, String_U8_Const b)
+{
+  b32 result = 0;
+  if (a.count == b.count)
+  {
+    u64 char_idx = 0;
+    while ((char_idx < a.count) && (a.s[char_idx] == b.s[char_idx]))
+    {
+      ++char_idx;
+    }
+    result = (char_idx == a.count);
+  }
+  return(result);
+}
+
+function u64
+test_reference_str8_find_first_string(String_U8_Const str, String_U8_Const to_find, u64 offset_from_beginning_of_source)
+{
+  u64 result = InvalidIndexU64;
+  if (to_find.count && (str.count >= to_find.count))
+  {
+    u64 one_past_last = str.count - to_find.count + 1;
+    for (u64 at = offset_from_beginning_of_source; at < one_past_last; ++at)
+    {
+      String_U8_Const substring = { str.s + at, to_find.count, to_find.count };
+      if (test_reference_str8_equal_strings(substring, to_find))
+      {
+        result = at;
+        break;
+      }
+    }
+  }
+  return(result);
+}
+
+function void
+test_string_search_fuzz(void)
+{
+  // NOTE(cj): every string gets its own malloc of exactly its size, so a SIMD
+  // load past the end shows up under a sanitizer. A three letter alphabet makes
+  // partial matches common, which is where the candidate masks go wrong.
+  PRNG32 rng;
+  prng32_seed(&rng, 3);
+  b32 find_agreed = 1;
+  b32 equal_agreed = 1;
+  for (u64 iteration = 0; iteration < 200000; ++iteration)
+  {
+    u64 str_count = prng32_rangeu32(&rng, 0, 200);
+    u64 to_find_count = prng32_rangeu32(&rng, 0, 40);
+    u8 *str_memory = malloc(Max(str_count, 1));
+    u8 *to_find_memory = malloc(Max(to_find_count, 1));
+    for (u64 char_idx = 0; char_idx < str_count; ++char_idx)
+    {
+      str_memory[char_idx] = (u8)('a' + prng32_rangeu32(&rng, 0, 3));
+    }
+    
+    // NOTE(cj): half the needles are cut out of the haystack, so they are found
+    u64 cut_at = 0;
+    b32 cut = (to_find_count <= str_count) && (prng32_nextu32(&rng) & 1);
+    if (cut)
+    {
+      cut_at = prng32_rangeu32(&rng, 0, (u32)(str_count - to_find_count + 1));
+      MemoryCopy(to_find_memory, str_memory + cut_at, to_find_count);
+    }
+    else
+    {
+      for (u64 char_idx = 0; char_idx < to_find_count; ++char_idx)
+      {
+        to_find_memory[char_idx] = (u8)('a' + prng32_rangeu32(&rng, 0, 3));
+      }
+    }
+    
+    String_U8_Const str = { str_memory, str_count, str_count };
+    String_U8_Const to_find = { to_find_memory, to_find_count, to_find_count };
+    u64 offset = prng32_rangeu32(&rng, 0, (u32)str_count + 2);
+    u64 expected = test_reference_str8_find_first_string(str, to_find, offset);
+    find_agreed &= (str8_find_first_string(str, to_find, offset) == expected);
+    
+    if (to_find_count <= str_count)
+    {
+      String_U8_Const substring = { str_memory + cut_at, to_find_count, to_find_count };
+      equal_agreed &= (str8_equal_strings(substring, to_find) == test_reference_str8_equal_strings(substring, to_find));
+    }
+    equal_agreed &= (str8_equal_strings(str, to_find) == test_reference_str8_equal_strings(str, to_find));
+    
+    free(str_memory);
+    free(to_find_memory);
+  }
+  TestCheck(find_agreed);
+  TestCheck(equal_agreed);
+  
+  TestCheck(str8_find_first_string(str8("hello###World"), str8("###"), 0) == 5);
+  TestCheck(str8_find_first_string(str8("hello###World"), str8("###"), 6) == InvalidIndexU64);
+  TestCheck(str8_find_first_string(str8("abc"), str8(""), 0) == InvalidIndexU64);
+}
+
+function void
+bench_string_search(void)
+{
+  printf("\n== string search (best of 5)\n");
+  printf("%-40s %12s %12s\n", "", "scalar", "current");
+  
+  M_Arena *arena = m_arena_reserve(MB(8));
+  u64 text_count = MB(1);
+  u8 *text = M_Arena_PushArray(arena, u8, text_count);
+  u8 *text_copy = M_Arena_PushArray(arena, u8, text_count);
+  PRNG32 rng;
+  prng32_seed(&rng, 9);
+  for (u64 char_idx = 0; char_idx < text_count; ++char_idx)
+  {
+    text[char_idx] = (u8)('a' + prng32_rangeu32(&rng, 0, 26));
+  }
+  MemoryCopy(text_copy, text, text_count);
+  text_copy[text_count - 1] ^= 1;
+  String_U8_Const haystack = { text, text_count, text_count };
+  String_U8_Const needle = str8("###");
+  
+  // NOTE(cj): UI identifiers, the one thing the game searches through every frame
+  String_U8_Const identifiers[] =
+  {
+    str8("hp_bar"), str8("exp_bar"), str8("Level 12###level_label"), str8("wave_label"),
+    str8("Wave 7###wave_label"), str8("fps###fps_label"), str8("pause_button"), str8("Resume###resume"),
+  };
+  
+  // NOTE(cj): through a pointer, so neither side gets inlined into the loop
+  u64 (* volatile find[2])(String_U8_Const, String_U8_Const, u64) = { test_reference_str8_find_first_string, str8_find_first_string };
+  b32 (* volatile equal[2])(String_U8_Const, String_U8_Const) = { test_reference_str8_equal_strings, str8_equal_strings };
+  
+  f64 best_secs[3][2] = { { 1e9, 1e9 }, { 1e9, 1e9 }, { 1e9, 1e9 } };
+  u64 sum = 0;
+  u64 identifier_rounds = 500000;
+  for (u32 run = 0; run < 5; ++run)
+  {
+    for (u32 version = 0; version < 2; ++version)
+    {
+      f64 start = test_seconds();
+      sum += find[version](haystack, needle, 0);
+      best_secs[0][version] = Min(best_secs[0][version], test_seconds() - start);
+      
+      // NOTE(cj): the strings only differ in the last byte
+      String_U8_Const a = { text, text_count, text_count };
+      String_U8_Const b = { text_copy, text_count, text_count };
+      start = test_seconds();
+      sum += equal[version](a, b);
+      best_secs[1][version] = Min(best_secs[1][version], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < identifier_rounds; ++round)
+      {
+        for (u64 identifier_idx = 0; identifier_idx < ArrayCount(identifiers); ++identifier_idx)
+        {
+          sum += find[version](identifiers[identifier_idx], needle, 0);
+        }
+      }
+      best_secs[2][version] = Min(best_secs[2][version], test_seconds() - start);
+    }
+  }
+  g_bench_sink += sum;
+  
+  printf("%-40s %7.2f GB/s %7.2f GB/s\n", "find \"###\" in 1MB, no match", (f64)text_count / best_secs[0][0] * 1e-9, (f64)text_count / best_secs[0][1] * 1e-9);
+  printf("%-40s %7.2f GB/s %7.2f GB/s\n", "equal 1MB, last byte differs", (f64)text_count / best_secs[1][0] * 1e-9, (f64)text_count / best_secs[1][1] * 1e-9);
+  f64 identifier_count = (f64)(identifier_rounds * ArrayCount(identifiers));
+  printf("%-40s %12.2f %12.2f\n", "find \"###\" in UI identifiers, ns each", best_secs[2][0] / identifier_count * 1e9, best_secs[2][1] / identifier_count * 1e9);
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Formatting
+//
+function String_U8_Const
+test_format_crt(M_Arena *arena, String_U8_Const format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  String_U8_Const result = str8_format_va_crt(arena, format, args);
+  va_end(args);
+  return(result);
+}
+
+function b32
+test_format_matches_crt(M_Arena *arena, char *format, ...)
+{
+  va_list args, crt_args;
+  va_start(args, format);
+  va_copy(crt_args, args);
+  
+  char expected[2048];
+  vsnprintf(expected, sizeof(expected), format, crt_args);
+  String_U8_Const format_str = { (u8 *)format, strlen(format), strlen(format) };
+  String_U8_Const formatted = str8_format_va(arena, format_str, args);
+  b32 result = ((formatted.count == strlen(expected)) &&
+                !memcmp(formatted.s, expected, formatted.count) &&
+                (formatted.s[formatted.count] == 0));
+  if (!result)
+  {
+    printf("format \"%s\": got \"%.*s\", expected \"%s\"\n", format, (int)formatted.count, (char *)formatted.s, expected);
+  }
+  
+  va_end(crt_args);
+  va_end(args);
+  return(result);
+}
+
+function void
+test_format(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(8));
+  TestCheck(test_format_matches_crt(arena, "plain"));
+  TestCheck(test_format_matches_crt(arena, ""));
+  TestCheck(test_format_matches_crt(arena, "%%%c%s|%s", 'x', "str", (char *)0));
+  TestCheck(test_format_matches_crt(arena, "%d %i %d %d", 0, -1, 2147483647, (-2147483647 - 1)));
+  TestCheck(test_format_matches_crt(arena, "%u %x %X", 4294967295u, 0xdeadbeefu, 0xabcu));
+  TestCheck(test_format_matches_crt(arena, "%ld %lu %lld %llu", -5l, 7ul, (long long)(-9223372036854775807ll - 1), 18446744073709551615llu));
+  TestCheck(test_format_matches_crt(arena, "%zu %zx %llx", (size_t)12345, (size_t)0xfff, 0x123456789abcdefllu));
+  TestCheck(test_format_matches_crt(arena, "%hd %hu %hhd %hhu %hx %hhx", 70000, 70000, 300, 300, 0x12345, 0x1ff));
+  TestCheck(test_format_matches_crt(arena, "%hd %hhd", -32769, -129));
+  TestCheck(test_format_matches_crt(arena, "%f %.0f %.1f %.2f %.9f", 3.14159, 2.5, -0.05, 1234.565, 1e-9));
+  TestCheck(test_format_matches_crt(arena, "%.2f %.2f %.0f %.0f", 0.125, 0.375, 0.5, 1.5));
+  TestCheck(test_format_matches_crt(arena, "%f %f %.3f", 1e300, -1e20, 0.0/0.0 > 0 ? 1.0 : -0.0));
+  
+  // NOTE(cj): random values and precisions, including short decimals that sit
+  // right next to a rounding tie in binary
+  PRNG32 rng;
+  prng32_seed(&rng, 13);
+  b32 all_f_matched = 1;
+  char *precision_formats[] = { "%.0f", "%.1f", "%.2f", "%.3f", "%.4f", "%.5f", "%.6f", "%.7f", "%.8f", "%.9f" };
+  for (u64 iteration = 0; (iteration < 200000) && all_f_matched; ++iteration)
+  {
+    u32 precision = prng32_rangeu32(&rng, 0, 10);
+    f64 v = (f64)prng32_nextu32(&rng) / (f64)(1u << prng32_rangeu32(&rng, 0, 32));
+    if (iteration & 1)
+    {
+      v = (f64)(s32)prng32_rangeu32(&rng, 0, 200000) / (f64)str8_powers_of_ten[prng32_rangeu32(&rng, 1, 6)] - 50.0;
+    }
+    u64 pos = m_arena_pos(arena);
+    all_f_matched &= test_format_matches_crt(arena, precision_formats[precision], v);
+    m_arena_pop_to(arena, pos);
+  }
+  TestCheck(all_f_matched);
+  
+  // NOTE(cj): precision on anything but %f, widths and flags all go to the crt
+  TestCheck(test_format_matches_crt(arena, "%.3s|%.5d|%.2x|%.0u", "truncate", 42, 7u, 0u));
+  TestCheck(test_format_matches_crt(arena, "%5d|%-4s|%08.3f|%+d|%e|%g", 3, "ab", 3.5, 4, 1234.5, 0.0001));
+  
+  // NOTE(cj): HUD strings
+  TestCheck(test_format_matches_crt(arena, "PlayerP###<%.2f, %.2f>", 123.456, -0.004));
+  TestCheck(test_format_matches_crt(arena, "player-hp###%u / %u", 73u, 100u));
+  TestCheck(test_format_matches_crt(arena, "%llu###status-effect-progress", 15llu));
+  
+  // NOTE(cj): a fallback after the writer had to move leaves the arena where it was
+  // before the call, plus the crt's string
+  u64 pos = m_arena_pos(arena);
+  char long_format[300];
+  memset(long_format, 'a', 200);
+  MemoryCopy(long_format + 200, "%s %5d", sizeof("%s %5d"));
+  char long_string[400];
+  memset(long_string, 'b', 399);
+  long_string[399] = 0;
+  TestCheck(test_format_matches_crt(arena, "%s %s %e", long_string, long_string, 1.0));
+  m_arena_pop_to(arena, pos);
+  String_U8_Const formatted = str8_format(arena, (String_U8_Const){ (u8 *)long_format, strlen(long_format), strlen(long_format) }, long_string, 7);
+  TestCheck(formatted.count == 200 + 399 + 6);
+  TestCheck(m_arena_pos(arena) == pos + AlignAToB(formatted.count + 1, 16));
+  
+  // NOTE(cj): same for a chained arena whose writer moved to the next block
+  M_Arena *chained = m_arena_reserve_flags(KB(64), M_ArenaFlag_Chained);
+  m_arena_push(chained, KB(64) - KB(1) - M_Arena_HeaderSize);
+  pos = m_arena_pos(chained);
+  formatted = str8_format(chained, (String_U8_Const){ (u8 *)long_format, strlen(long_format), strlen(long_format) }, long_string, 7);
+  TestCheck(formatted.count == 200 + 399 + 6);
+  TestCheck(formatted.s[formatted.count - 1] == '7');
+  m_arena_pop_to(chained, pos);
+  TestCheck(m_arena_pos(chained) == pos);
+  TestCheck(chained->current == chained);
+  m_arena_release(chained);
+  m_arena_release(arena);
+}
+
+function void
+bench_format(void)
+{
+  printf("\n== formatting the HUD strings, ns per string (best of 5)\n");
+  printf("%-32s %12s %12s %12s\n", "", "vsnprintf", "crt path", "str8_format");
+  
+  M_Arena *arena = m_arena_reserve(MB(8));
+  u64 round_count = 200000;
+  f64 best_secs[4][3];
+  for (u64 idx = 0; idx < 12; ++idx)
+  {
+    best_secs[idx / 3][idx % 3] = 1e9;
+  }
+  char *names[4] = { "player-hp###%u / %u", "%llu###status-effect-progress", "PlayerP###<%.2f, %.2f>", "Consumable###%.2f / %.2f" };
+  u64 sum = 0;
+  for (u32 run = 0; run < 5; ++run)
+  {
+    for (u32 version = 0; version < 3; ++version)
+    {
+      for (u64 format_idx = 0; format_idx < 4; ++format_idx)
+      {
+        String_U8_Const format = { (u8 *)names[format_idx], strlen(names[format_idx]), strlen(names[format_idx]) };
+        u64 pos = m_arena_pos(arena);
+        f64 start = test_seconds();
+        for (u64 round = 0; round < round_count; ++round)
+        {
+          u32 a = (u32)round;
+          f64 x = (f64)round * 0.37;
+          char buffer[128];
+          String_U8_Const formatted = {0};
+          switch (format_idx * 3 + version)
+          {
+            case 0: { sum += snprintf(buffer, sizeof(buffer), names[0], a, 100u); } break;
+            case 1: { formatted = test_format_crt(arena, format, a, 100u); } break;
+            case 2: { formatted = str8_format(arena, format, a, 100u); } break;
+            case 3: { sum += snprintf(buffer, sizeof(buffer), names[1], (unsigned long long)a); } break;
+            case 4: { formatted = test_format_crt(arena, format, (unsigned long long)a); } break;
+            case 5: { formatted = str8_format(arena, format, (unsigned long long)a); } break;
+            case 6: { sum += snprintf(buffer, sizeof(buffer), names[2], x, -x); } break;
+            case 7: { formatted = test_format_crt(arena, format, x, -x); } break;
+            case 8: { formatted = str8_format(arena, format, x, -x); } break;
+            case 9: { sum += snprintf(buffer, sizeof(buffer), names[3], x, 100.0); } break;
+            case 10: { formatted = test_format_crt(arena, format, x, 100.0); } break;
+            case 11: { formatted = str8_format(arena, format, x, 100.0); } break;
+          }
+          sum += formatted.count;
+          m_arena_pop_to(arena, pos);
+        }
+        best_secs[format_idx][version] = Min(best_secs[format_idx][version], test_seconds() - start);
+      }
+    }
+  }
+  g_bench_sink += sum;
+  
+  for (u64 format_idx = 0; format_idx < 4; ++format_idx)
+  {
+    printf("%-32s %12.1f %12.1f %12.1f\n", names[format_idx],
+           best_secs[format_idx][0] / (f64)round_count * 1e9, best_secs[format_idx][1] / (f64)round_count * 1e9,
+           best_secs[format_idx][2] / (f64)round_count * 1e9);
+  }
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): String hashing
+//
+// NOTE(cj): the hash str8_calculate_hash used before wyhash. Only the last 13
+// characters reach the top bits, and the low 7 bits (the bucket in a 128 entry
+// table) come from the last two characters.
+function u64
+test_reference_str8_hash_shift5(String_U8_Const str, u64 base)
+{
+  u64 result = base;
+  for (u64 idx = 0; idx < str.count; ++idx)
+  {
+    result = (result << 5) + (u64)str.s[idx];
+  }
+  return(result);
+}
+
+// NOTE(cj): the identifiers the HUD builds in a frame, with the format strings
+// filled in the way game_update_ui fills them
+function u64
+test_hud_identifiers(M_Arena *arena, String_U8_Const *identifiers, u64 max_count)
+{
+  String_U8_Const fixed[] =
+  {
+    str8("main-sidebar"), str8("player-section"), str8("player-section-left-side"),
+    str8("player-section-right-side"), str8("player-health"), str8("player-health-border"),
+    str8("player-exp-border"), str8("stats-section"), str8("status-effect-container"),
+    str8("debug-bar"), str8("side-label###Player"), str8("side-label###Stats"),
+    str8("side-label###Debug Hax"), str8("Health:"), str8("Experience:"), str8("Level:"),
+    str8("Wave:"), str8("Enemies Alive:"), str8("Healing Effect"),
+  };
+  u64 count = 0;
+  for (u64 fixed_idx = 0; (fixed_idx < ArrayCount(fixed)) && (count < max_count); ++fixed_idx)
+  {
+    identifiers[count++] = fixed[fixed_idx];
+  }
+  
+  for (u64 effect_idx = 0; (effect_idx < 16) && ((count + 3) <= max_count); ++effect_idx)
+  {
+    identifiers[count++] = str8_format(arena, str8("%llu###status-effect"), effect_idx);
+    identifiers[count++] = str8_format(arena, str8("%llu###status-effect-progress"), effect_idx);
+    identifiers[count++] = str8_format(arena, str8("%llu###status-effect-texture"), effect_idx);
+  }
+  
+  if ((count + 6) <= max_count)
+  {
+    identifiers[count++] = str8_format(arena, str8("player-hp###%u / %u"), 73, 100);
+    identifiers[count++] = str8_format(arena, str8("player-exp###%u / %u"), 180, 250);
+    identifiers[count++] = str8_format(arena, str8("player-level###%u"), 7);
+    identifiers[count++] = str8_format(arena, str8("WaveNum###%u"), 12);
+    identifiers[count++] = str8_format(arena, str8("EntityCount###%u"), 341);
+    identifiers[count++] = str8_format(arena, str8("PlayerP###<%.2f, %.2f>"), 123.25, -48.5);
+  }
+  return(count);
+}
+
+function void
+test_string_hash(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(1));
+  String_U8_Const identifiers[128];
+  u64 identifier_count = test_hud_identifiers(arena, identifiers, ArrayCount(identifiers));
+  b32 all_distinct = 1;
+  for (u64 identifier_idx = 0; identifier_idx < identifier_count; ++identifier_idx)
+  {
+    u64 hash = str8_calculate_hash(identifiers[identifier_idx], 0);
+    for (u64 other_idx = 0; other_idx < identifier_idx; ++other_idx)
+    {
+      all_distinct &= (hash != str8_calculate_hash(identifiers[other_idx], 0));
+    }
+  }
+  TestCheck(all_distinct);
+  
+  // NOTE(cj): same bytes at a different address hash the same, the base changes it
+  u8 copy[32];
+  String_U8_Const original = str8("side-label###Player");
+  MemoryCopy(copy, original.s, original.count);
+  String_U8_Const copied = { copy, original.count, original.count };
+  TestCheck(str8_calculate_hash(original, 0) == str8_calculate_hash(copied, 0));
+  TestCheck(str8_calculate_hash(original, 0) != str8_calculate_hash(original, 1));
+  TestCheck(str8_calculate_hash(str8(""), 0) != str8_calculate_hash(str8("a"), 0));
+  m_arena_release(arena);
+}
+
+function void
+bench_string_hash(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(1));
+  String_U8_Const identifiers[128];
+  u64 identifier_count = test_hud_identifiers(arena, identifiers, ArrayCount(identifiers));
+  
+  printf("\n== string hash on the %llu HUD identifiers, 128 bucket chained table\n", (unsigned long long)identifier_count);
+  printf("%-14s %12s %10s %10s %12s %14s\n", "", "equal pairs", "buckets", "longest", "avg probes", "lookup ns");
+  
+  u64 (* volatile hashes[2])(String_U8_Const, u64) = { test_reference_str8_hash_shift5, str8_calculate_hash };
+  char *names[2] = { "(h<<5)+c", "wyhash" };
+  for (u64 hash_idx = 0; hash_idx < ArrayCount(hashes); ++hash_idx)
+  {
+    u64 keys[ArrayCount(identifiers)];
+    u32 chain_lengths[128] = {0};
+    u64 same_hash_count = 0;
+    for (u64 identifier_idx = 0; identifier_idx < identifier_count; ++identifier_idx)
+    {
+      keys[identifier_idx] = hashes[hash_idx](identifiers[identifier_idx], 0);
+      chain_lengths[keys[identifier_idx] & 127] += 1;
+      for (u64 other_idx = 0; other_idx < identifier_idx; ++other_idx)
+      {
+        same_hash_count += (keys[other_idx] == keys[identifier_idx]);
+      }
+    }
+    
+    // NOTE(cj): a lookup walks half its chain on average, plus itself
+    u64 used_buckets = 0;
+    u64 longest_chain = 0;
+    f64 probe_total = 0;
+    for (u64 bucket_idx = 0; bucket_idx < 128; ++bucket_idx)
+    {
+      used_buckets += (chain_lengths[bucket_idx] != 0);
+      longest_chain = Max(longest_chain, chain_lengths[bucket_idx]);
+      probe_total += (f64)chain_lengths[bucket_idx] * (f64)(chain_lengths[bucket_idx] + 1) * 0.5;
+    }
+    
+    // NOTE(cj): the lookup the UI did per widget: hash the identifier, walk the
+    // bucket comparing strings
+    String_U8_Const *buckets[128][ArrayCount(identifiers)];
+    u32 bucket_counts[128] = {0};
+    for (u64 identifier_idx = 0; identifier_idx < identifier_count; ++identifier_idx)
+    {
+      u64 bucket_idx = keys[identifier_idx] & 127;
+      buckets[bucket_idx][bucket_counts[bucket_idx]++] = &identifiers[identifier_idx];
+    }
+    
+    u64 round_count = 100000;
+    f64 best_secs = 1e9;
+    u64 sum = 0;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        for (u64 identifier_idx = 0; identifier_idx < identifier_count; ++identifier_idx)
+        {
+          String_U8_Const identifier = identifiers[identifier_idx];
+          u64 bucket_idx = hashes[hash_idx](identifier, 0) & 127;
+          u64 at = 0;
+          while (!str8_equal_strings(*buckets[bucket_idx][at], identifier))
+          {
+            ++at;
+          }
+          sum += at;
+        }
+      }
+      best_secs = Min(best_secs, test_seconds() - start);
+    }
+    g_bench_sink += sum;
+    
+    printf("%-14s %12llu %7llu/128 %10llu %12.2f %14.2f\n", names[hash_idx],
+           (unsigned long long)same_hash_count, (unsigned long long)used_buckets, (unsigned long long)longest_chain,
+           probe_total / (f64)identifier_count, best_secs / (f64)(round_count*identifier_count) * 1e9);
+  }
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): PRNG32 bulk generation
+//
+function void
+test_prng_fill(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(4));
+  u64 max_count = 10000;
+  u32 *expected = M_Arena_PushArray(arena, u32, max_count);
+  u32 *got = M_Arena_PushArray(arena, u32, max_count);
+  f32 *expected_f32 = M_Arena_PushArray(arena, f32, max_count);
+  f32 *got_f32 = M_Arena_PushArray(arena, f32, max_count);
+  
+  // NOTE(cj): every count up to a few lane groups (tails of every length), then a
+  // long one. The generator has to end up where count sequential draws leave it.
+  u64 counts[48];
+  for (u64 count_idx = 0; count_idx < 47; ++count_idx)
+  {
+    counts[count_idx] = count_idx;
+  }
+  counts[47] = max_count;
+  
+  b32 all_u32_matched = 1;
+  b32 all_f32_matched = 1;
+  b32 all_range_matched = 1;
+  b32 all_states_matched = 1;
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 count = counts[count_idx];
+    PRNG32 sequential, bulk;
+    prng32_seed_stream(&sequential, 100 + count, count);
+    bulk = sequential;
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      expected[idx] = prng32_nextu32(&sequential);
+    }
+    prng32_fill_u32(&bulk, got, count);
+    all_u32_matched &= !memcmp(expected, got, count*sizeof(u32));
+    all_states_matched &= (sequential.state == bulk.state);
+    
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      expected_f32[idx] = prng32_nextf32(&sequential);
+    }
+    prng32_fill_f32_01(&bulk, got_f32, count);
+    all_f32_matched &= !memcmp(expected_f32, got_f32, count*sizeof(f32));
+    all_states_matched &= (sequential.state == bulk.state);
+    
+    // NOTE(cj): a bound near 2^32 rejects often, a small one almost never
+    u32 bounds[][2] = { { 0, 6 }, { 10, 1000 }, { 0, 0xC0000001 }, { 0, 0xFFFFFFFF } };
+    for (u64 bound_idx = 0; bound_idx < ArrayCount(bounds); ++bound_idx)
+    {
+      u32 low = bounds[bound_idx][0];
+      u32 high = bounds[bound_idx][1];
+      for (u64 idx = 0; idx < count; ++idx)
+      {
+        expected[idx] = prng32_rangeu32(&sequential, low, high);
+      }
+      prng32_fill_range_u32(&bulk, got, count, low, high);
+      all_range_matched &= !memcmp(expected, got, count*sizeof(u32));
+      all_states_matched &= (sequential.state == bulk.state);
+    }
+  }
+  TestCheck(all_u32_matched);
+  TestCheck(all_f32_matched);
+  TestCheck(all_range_matched);
+  TestCheck(all_states_matched);
+  
+  m_arena_release(arena);
+}
+
+function void
+test_prng_advance(void)
+{
+  // NOTE(cj): advance(n) has to land exactly where n prng32_nextu32 calls do, for
+  // small n, n around the powers of two the jump squares through, and big n
+  u64 deltas[] = { 0, 1, 2, 3, 7, 8, 9, 63, 64, 65, 1000, 4095, 4096, 4097, 123457, 1000000 };
+  b32 all_forward_matched = 1;
+  b32 all_back_matched = 1;
+  for (u64 delta_idx = 0; delta_idx < ArrayCount(deltas); ++delta_idx)
+  {
+    u64 delta = deltas[delta_idx];
+    PRNG32 sequential, jumped;
+    prng32_seed_stream(&sequential, 77, delta);
+    jumped = sequential;
+    PRNG32 start = sequential;
+    for (u64 step = 0; step < delta; ++step)
+    {
+      prng32_nextu32(&sequential);
+    }
+    prng32_advance(&jumped, delta);
+    all_forward_matched &= (jumped.state == sequential.state) && (jumped.inc == sequential.inc);
+    all_forward_matched &= (prng32_nextu32(&jumped) == prng32_nextu32(&sequential));
+    
+    // NOTE(cj): negative deltas go back, so -(delta + 1) undoes the above
+    prng32_advance(&jumped, -(s64)(delta + 1));
+    all_back_matched &= (jumped.state == start.state);
+  }
+  TestCheck(all_forward_matched);
+  TestCheck(all_back_matched);
+  
+  // NOTE(cj): 2^64 steps is the whole period, back to the start
+  {
+    PRNG32 rng;
+    prng32_seed(&rng, 5);
+    u64 start_state = rng.state;
+    prng32_advance(&rng, 1ull << 63);
+    TestCheck(rng.state != start_state);
+    prng32_advance(&rng, 1ull << 63);
+    TestCheck(rng.state == start_state);
+  }
+  
+  // NOTE(cj): same seed, different streams: the outputs must differ, and neither
+  // stream's first outputs may show up as a run in the other
+  {
+    PRNG32 a, b;
+    prng32_seed_stream(&a, 42, 1);
+    prng32_seed_stream(&b, 42, 2);
+    u32 a_values[1024], b_values[1024];
+    u64 same_count = 0;
+    for (u64 idx = 0; idx < ArrayCount(a_values); ++idx)
+    {
+      a_values[idx] = prng32_nextu32(&a);
+      b_values[idx] = prng32_nextu32(&b);
+      same_count += (a_values[idx] == b_values[idx]);
+    }
+    TestCheck(same_count == 0);
+    
+    b32 found_run = 0;
+    for (u64 a_idx = 0; a_idx + 1 < ArrayCount(a_values); ++a_idx)
+    {
+      for (u64 b_idx = 0; b_idx + 1 < ArrayCount(b_values); ++b_idx)
+      {
+        found_run |= (a_values[a_idx] == b_values[b_idx]) && (a_values[a_idx + 1] == b_values[b_idx + 1]);
+      }
+    }
+    TestCheck(!found_run);
+  }
+}
+
+// NOTE(cj): the loop prng32_fill_u32 replaced
+function void
+bench_prng_sequential_fill_u32(PRNG32 *rng, u32 *dest, u64 count)
+{
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    dest[idx] = prng32_nextu32(rng);
+  }
+}
+
+function void
+bench_prng_fill(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2, 2x4 lanes";
+#else
+  char *lanes_name = "scalar, 4 lanes";
+#endif
+  printf("\n== prng32 fill: 4096 u32s at a time (16KB, stays in L1), 256MB total (best of 5)\n");
+  printf("%-32s %10s %12s\n", "", "GB/s", "ns per u32");
+  
+  M_Arena *arena = m_arena_reserve(MB(1));
+  u64 count = 4096;
+  u64 round_count = 16384;
+  u32 *dest = M_Arena_PushArray(arena, u32, count);
+  
+  void (* volatile fills[])(PRNG32 *, u32 *, u64) = { bench_prng_sequential_fill_u32, prng32_fill_u32 };
+  char *names[] = { "prng32_nextu32 loop", lanes_name };
+  for (u64 fill_idx = 0; fill_idx < ArrayCount(fills); ++fill_idx)
+  {
+    PRNG32 rng;
+    prng32_seed(&rng, 21);
+    f64 best_secs = 1e9;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        fills[fill_idx](&rng, dest, count);
+      }
+      best_secs = Min(best_secs, test_seconds() - start);
+      g_bench_sink += dest[count - 1];
+    }
+    
+    f64 total_count = (f64)(count*round_count);
+    printf("%-32s %10.2f %12.3f\n", names[fill_idx], total_count*sizeof(u32) / best_secs * 1e-9, best_secs / total_count * 1e9);
+  }
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Batch math kernels
+//
+function v3f_soa
+test_push_random_soa(M_Arena *arena, PRNG32 *rng, u64 count, f32 range)
+{
+  v3f_soa result;
+  f32 **components[] = { &result.x, &result.y, &result.z };
+  for (u64 component_idx = 0; component_idx < ArrayCount(components); ++component_idx)
+  {
+    f32 *values = M_Arena_PushArray(arena, f32, count);
+    prng32_fill_f32_01(rng, values, count);
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      values[idx] = (values[idx]*2.0f - 1.0f)*range;
+    }
+    *components[component_idx] = values;
+  }
+  return(result);
+}
+
+function v3f_soa
+test_push_soa(M_Arena *arena, u64 count)
+{
+  v3f_soa result;
+  result.x = M_Arena_PushArray(arena, f32, count);
+  result.y = M_Arena_PushArray(arena, f32, count);
+  result.z = M_Arena_PushArray(arena, f32, count);
+  return(result);
+}
+
+function v3f
+test_soa_get(v3f_soa soa, u64 idx)
+{
+  v3f result = v3f_make(soa.x[idx], soa.y[idx], soa.z[idx]);
+  return(result);
+}
+
+// NOTE(cj): how many elements of dest differ from what the scalar helper gives
+function u64
+test_soa_mismatches(v3f_soa dest, v3f *expected, u64 count)
+{
+  u64 result = 0;
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    result += ((dest.x[idx] != expected[idx].x) || (dest.y[idx] != expected[idx].y) || (dest.z[idx] != expected[idx].z));
+  }
+  return(result);
+}
+
+// NOTE(cj): the batch kernels promise the same results as the scalar helpers per
+// element, so this wants them bit for bit equal, not just close
+function void
+test_batch_math(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(32));
+  PRNG32 rng;
+  prng32_seed(&rng, 17);
+  
+  // NOTE(cj): 1003 leaves a tail for the scalar loop after the wide one
+  u64 counts[] = { 1000, 10000, 100000, 1003 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 count = counts[count_idx];
+    u64 pos = m_arena_pos(arena);
+    v3f_soa a = test_push_random_soa(arena, &rng, count, 100.0f);
+    v3f_soa b = test_push_random_soa(arena, &rng, count, 100.0f);
+    v3f_soa dest = test_push_soa(arena, count);
+    v3f *expected = M_Arena_PushArray(arena, v3f, count);
+    f32 *expected_f32 = M_Arena_PushArray(arena, f32, count);
+    f32 t = 0.3f;
+    f32 s = -2.5f;
+    
+    // NOTE(cj): some pairs on top of each other and some just inside and outside
+    // the normalize cutoff, so the zero case gets hit
+    for (u64 idx = 0; idx < count; idx += 7)
+    {
+      f32 offset = ((idx / 7) % 3 == 0) ? 0.0f : (((idx / 7) % 3 == 1) ? 0.00005f : 0.0002f);
+      b.x[idx] = a.x[idx] + offset;
+      b.y[idx] = a.y[idx];
+      b.z[idx] = a.z[idx];
+    }
+    
+    v3f_batch_sub_and_normalize_or_zero(dest, a, b, count);
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      expected[idx] = v3f_sub_and_normalize_or_zero(test_soa_get(a, idx), test_soa_get(b, idx));
+    }
+    TestCheck(test_soa_mismatches(dest, expected, count) == 0);
+    
+    v3f_batch_lerp(dest, a, b, t, count);
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      expected[idx] = v3f_lerp(test_soa_get(a, idx), test_soa_get(b, idx), t);
+    }
+    TestCheck(test_soa_mismatches(dest, expected, count) == 0);
+    
+    // NOTE(cj): the f32 kernels, run over the three components as one array each
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      expected[idx] = v3f_add(test_soa_get(a, idx), test_soa_get(b, idx));
+    }
+    f32_batch_add(dest.x, a.x, b.x, count);
+    f32_batch_add(dest.y, a.y, b.y, count);
+    f32_batch_add(dest.z, a.z, b.z, count);
+    TestCheck(test_soa_mismatches(dest, expected, count) == 0);
+    
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      v3f av = test_soa_get(a, idx);
+      v3f bv = test_soa_get(b, idx);
+      expected[idx] = v3f_make(av.x*s, av.y*s, av.z*s);
+      expected_f32[idx] = av.x + bv.x*s;
+    }
+    f32_batch_scale(dest.x, a.x, s, count);
+    f32_batch_scale(dest.y, a.y, s, count);
+    f32_batch_scale(dest.z, a.z, s, count);
+    TestCheck(test_soa_mismatches(dest, expected, count) == 0);
+    f32_batch_add_scaled(dest.x, a.x, b.x, s, count);
+    TestCheck(!memcmp(dest.x, expected_f32, count*sizeof(f32)));
+    
+    v3f point = v3f_make(3.0f, -7.0f, 0.5f);
+    v3f_batch_distance_sq(dest.x, a, point, count);
+    u64 distance_mismatches = 0;
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      v3f d = v3f_sub(test_soa_get(a, idx), point);
+      distance_mismatches += (dest.x[idx] != d.x*d.x + d.y*d.y + d.z*d.z);
+    }
+    TestCheck(distance_mismatches == 0);
+    
+    // NOTE(cj): in place
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      expected[idx] = v3f_lerp(test_soa_get(a, idx), test_soa_get(b, idx), t);
+    }
+    v3f_batch_lerp(a, a, b, t, count);
+    TestCheck(test_soa_mismatches(a, expected, count) == 0);
+    
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+typedef struct
+{
+  u64 count;
+  v3f *a_aos;
+  v3f *b_aos;
+  v3f *dest_aos;
+  v3f_soa a;
+  v3f_soa b;
+  v3f_soa dest;
+  f32 *dest_f32;
+} Bench_BatchData;
+
+// NOTE(cj): the per entity loops over AoS v3fs the kernels replace, next to the
+// kernels themselves, all with the same signature so they go through one pointer
+no_inline function void
+bench_aos_normalize(Bench_BatchData *data)
+{
+  for (u64 idx = 0; idx < data->count; ++idx)
+  {
+    data->dest_aos[idx] = v3f_sub_and_normalize_or_zero(data->a_aos[idx], data->b_aos[idx]);
+  }
+}
+
+no_inline function void
+bench_soa_normalize(Bench_BatchData *data)
+{
+  v3f_batch_sub_and_normalize_or_zero(data->dest, data->a, data->b, data->count);
+}
+
+no_inline function void
+bench_aos_lerp(Bench_BatchData *data)
+{
+  for (u64 idx = 0; idx < data->count; ++idx)
+  {
+    data->dest_aos[idx] = v3f_lerp(data->a_aos[idx], data->b_aos[idx], 0.3f);
+  }
+}
+
+no_inline function void
+bench_soa_lerp(Bench_BatchData *data)
+{
+  v3f_batch_lerp(data->dest, data->a, data->b, 0.3f, data->count);
+}
+
+no_inline function void
+bench_aos_distance_sq(Bench_BatchData *data)
+{
+  v3f point = v3f_make(3.0f, -7.0f, 0.5f);
+  for (u64 idx = 0; idx < data->count; ++idx)
+  {
+    v3f d = v3f_sub(data->a_aos[idx], point);
+    data->dest_f32[idx] = d.x*d.x + d.y*d.y + d.z*d.z;
+  }
+}
+
+no_inline function void
+bench_soa_distance_sq(Bench_BatchData *data)
+{
+  v3f_batch_distance_sq(data->dest_f32, data->a, v3f_make(3.0f, -7.0f, 0.5f), data->count);
+}
+
+no_inline function void
+bench_aos_add(Bench_BatchData *data)
+{
+  for (u64 idx = 0; idx < data->count; ++idx)
+  {
+    v3f_add_eq(data->dest_aos + idx, data->b_aos[idx]);
+  }
+}
+
+no_inline function void
+bench_soa_add(Bench_BatchData *data)
+{
+  f32_batch_add(data->dest.x, data->dest.x, data->b.x, data->count);
+  f32_batch_add(data->dest.y, data->dest.y, data->b.y, data->count);
+  f32_batch_add(data->dest.z, data->dest.z, data->b.z, data->count);
+}
+
+function void
+bench_batch_math(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  printf("\n== batch math (%s): scalar helpers over AoS v3f vs batch kernels over SoA, 20M elements per run (best of 5)\n", lanes_name);
+  printf("%-20s %8s %14s %14s %9s\n", "", "count", "AoS ns/elem", "SoA ns/elem", "speedup");
+  
+  M_Arena *arena = m_arena_reserve(MB(32));
+  PRNG32 rng;
+  prng32_seed(&rng, 19);
+  
+  void (* volatile aos_kernels[])(Bench_BatchData *) = { bench_aos_normalize, bench_aos_lerp, bench_aos_distance_sq, bench_aos_add };
+  void (* volatile soa_kernels[])(Bench_BatchData *) = { bench_soa_normalize, bench_soa_lerp, bench_soa_distance_sq, bench_soa_add };
+  char *names[] = { "sub+normalize_or_0", "lerp", "distance_sq", "add" };
+  
+  u64 counts[] = { 1000, 10000, 100000 };
+  for (u64 kernel_idx = 0; kernel_idx < ArrayCount(names); ++kernel_idx)
+  {
+    for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+    {
+      u64 pos = m_arena_pos(arena);
+      Bench_BatchData data;
+      data.count = counts[count_idx];
+      data.a = test_push_random_soa(arena, &rng, data.count, 100.0f);
+      data.b = test_push_random_soa(arena, &rng, data.count, 100.0f);
+      data.dest = test_push_random_soa(arena, &rng, data.count, 100.0f);
+      data.a_aos = M_Arena_PushArray(arena, v3f, data.count);
+      data.b_aos = M_Arena_PushArray(arena, v3f, data.count);
+      data.dest_aos = M_Arena_PushArray(arena, v3f, data.count);
+      data.dest_f32 = M_Arena_PushArray(arena, f32, data.count);
+      for (u64 idx = 0; idx < data.count; ++idx)
+      {
+        data.a_aos[idx] = test_soa_get(data.a, idx);
+        data.b_aos[idx] = test_soa_get(data.b, idx);
+        data.dest_aos[idx] = test_soa_get(data.dest, idx);
+      }
+      
+      u64 round_count = 20000000 / data.count;
+      f64 best_secs[2] = { 1e9, 1e9 };
+      for (u32 run = 0; run < 5; ++run)
+      {
+        for (u64 side = 0; side < 2; ++side)
+        {
+          void (*kernel)(Bench_BatchData *) = side ? soa_kernels[kernel_idx] : aos_kernels[kernel_idx];
+          f64 start = test_seconds();
+          for (u64 round = 0; round < round_count; ++round)
+          {
+            kernel(&data);
+          }
+          best_secs[side] = Min(best_secs[side], test_seconds() - start);
+        }
+      }
+      g_bench_sink += (u64)data.dest.x[0] + (u64)data.dest_aos[0].x + (u64)data.dest_f32[0];
+      
+      f64 element_count = (f64)(round_count*data.count);
+      printf("%-20s %8llu %14.3f %14.3f %8.2fx\n", names[kernel_idx], (unsigned long long)data.count,
+             best_secs[0] / element_count * 1e9, best_secs[1] / element_count * 1e9, best_secs[0] / best_secs[1]);
+      m_arena_pop_to(arena, pos);
+    }
+  }
+  
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Fast approximations. The error table here is where the bounds in the
+// comment in mathematical_objects.h come from: "tests bench" prints it, and the
+// tests check the measured errors stay under those bounds.
+//
+typedef enum
+{
+  Test_SinCos_CRT,
+  Test_SinCos_Fast,
+  Test_SinCos_BatchFast,
+} Test_SinCos;
+
+typedef struct
+{
+  f64 sin_error;
+  f64 cos_error;
+  u64 sample_count;
+} Test_SinCosError;
+
+// NOTE(cj): max abs error against the double precision libm sin/cos over every
+// stride'th f32 in (min_x, max_x], and their negations
+function Test_SinCosError
+test_sincos_error(Test_SinCos which, f32 min_x, f32 max_x, u32 stride)
+{
+  Test_SinCosError result = { 0 };
+  f32 x[256], x_sin[256], x_cos[256];
+  u32 max_bits, bits;
+  MemoryCopy(&bits, &min_x, sizeof(bits));
+  MemoryCopy(&max_bits, &max_x, sizeof(max_bits));
+  bits += 1;
+  while (bits <= max_bits)
+  {
+    u64 count = 0;
+    for (; (count < ArrayCount(x)) && (bits <= max_bits); count += 2, bits += stride)
+    {
+      MemoryCopy(x + count, &bits, sizeof(f32));
+      x[count + 1] = -x[count];
+    }
+    
+    if (which == Test_SinCos_BatchFast)
+    {
+      f32_batch_sincos_fast(x_sin, x_cos, x, count);
+    }
+    else
+    {
+      for (u64 idx = 0; idx < count; ++idx)
+      {
+        if (which == Test_SinCos_Fast)
+        {
+          f32_sincos_fast(x[idx], x_sin + idx, x_cos + idx);
+        }
+        else
+        {
+          x_sin[idx] = sinf(x[idx]);
+          x_cos[idx] = cosf(x[idx]);
+        }
+      }
+    }
+    
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      result.sin_error = Max(result.sin_error, fabs((f64)x_sin[idx] - sin((f64)x[idx])));
+      result.cos_error = Max(result.cos_error, fabs((f64)x_cos[idx] - cos((f64)x[idx])));
+    }
+    result.sample_count += count;
+  }
+  return(result);
+}
+
+// NOTE(cj): max relative error against 1/sqrt in double over every f32 in [1, 4).
+// Both versions look at the exponent's parity and the top of the mantissa, so
+// the error over [1, 4) repeats for every other power of four.
+function f64
+test_rsqrt_error(b32 batch)
+{
+  f64 result = 0;
+  f32 x[256], y[256];
+  f32 min_x = 1.0f;
+  f32 end_x = 4.0f;
+  u32 bits, end_bits;
+  MemoryCopy(&bits, &min_x, sizeof(bits));
+  MemoryCopy(&end_bits, &end_x, sizeof(end_bits));
+  while (bits < end_bits)
+  {
+    u64 count = 0;
+    for (; (count < ArrayCount(x)) && (bits < end_bits); ++count, ++bits)
+    {
+      MemoryCopy(x + count, &bits, sizeof(f32));
+    }
+    
+    if (batch)
+    {
+      f32_batch_rsqrt_fast(y, x, count);
+    }
+    else
+    {
+      for (u64 idx = 0; idx < count; ++idx)
+      {
+        y[idx] = f32_rsqrt_fast(x[idx]);
+      }
+    }
+    
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      f64 expected = 1.0 / sqrt((f64)x[idx]);
+      result = Max(result, fabs((f64)y[idx] - expected) / expected);
+    }
+  }
+  return(result);
+}
+
+// NOTE(cj): the bounds documented in mathematical_objects.h
+#define Test_SinCosBound1000 1.0e-7
+#define Test_SinCosBound8192 1.6e-7
+#if defined(DR_SIMD_SSE2)
+# define Test_RSqrtBound 2.8e-7
+#else
+# define Test_RSqrtBound 4.8e-6
+#endif
+
+function void
+test_fast_math(void)
+{
+  // NOTE(cj): coarser than the table in bench_fast_math, to keep the tests quick
+  Test_SinCos versions[] = { Test_SinCos_Fast, Test_SinCos_BatchFast };
+  for (u64 version_idx = 0; version_idx < ArrayCount(versions); ++version_idx)
+  {
+    Test_SinCosError error_1000 = test_sincos_error(versions[version_idx], 0.0f, 1000.0f, 4096);
+    Test_SinCosError error_8192 = test_sincos_error(versions[version_idx], 1000.0f, 8192.0f, 256);
+    TestCheck(error_1000.sin_error <= Test_SinCosBound1000);
+    TestCheck(error_1000.cos_error <= Test_SinCosBound1000);
+    TestCheck(error_8192.sin_error <= Test_SinCosBound8192);
+    TestCheck(error_8192.cos_error <= Test_SinCosBound8192);
+  }
+  
+  TestCheck(test_rsqrt_error(0) <= Test_RSqrtBound);
+  TestCheck(test_rsqrt_error(1) <= Test_RSqrtBound);
+  
+  // NOTE(cj): exact zeros come out of the _fast normalize as zero, like the exact one
+  v3f n = v3f_sub_and_normalize_or_zero_fast(v3f_make(1, 2, 3), v3f_make(1, 2, 3));
+  TestCheck((n.x == 0) && (n.y == 0) && (n.z == 0));
+  n = v3f_sub_and_normalize_or_zero_fast(v3f_make(3, 4, 0), v3f_make(0, 0, 0));
+  TestCheck((fabsf(n.x - 0.6f) < 1e-5f) && (fabsf(n.y - 0.8f) < 1e-5f) && (n.z == 0));
+}
+
+// NOTE(cj): the batched chase step against the scalar exact one (the step the
+// per entity loop used to take), in double precision. Counts that aren't a
+// multiple of the lane width run the scalar tail too. Points on the target, or
+// well inside the 0.0001 cutoff, step by exactly zero. Points close to the
+// cutoff are left out, either answer is right there.
+function void
+test_step_toward(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(8));
+  PRNG32 rng;
+  prng32_seed(&rng, 22);
+  v2f target = v2f_make(37.5f, -12.25f);
+  f32 step = 32.0f / 60.0f;
+  
+  u64 counts[] = { 1, 3, 8, 13, 1000, 1027 };
+  b32 steps_matched = 1;
+  b32 zeros_matched = 1;
+  f64 max_error = 0;
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u64 count = counts[count_idx];
+    f32 *x = M_Arena_PushArray(arena, f32, count);
+    f32 *y = M_Arena_PushArray(arena, f32, count);
+    f32 *step_x = M_Arena_PushArray(arena, f32, count);
+    f32 *step_y = M_Arena_PushArray(arena, f32, count);
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      f32 range = ((idx % 5) == 1) ? 0.00001f : ((idx % 5) == 2) ? 1.0f : 5000.0f;
+      x[idx] = target.x + (prng32_nextf32(&rng)*2.0f - 1.0f)*range;
+      y[idx] = target.y + (prng32_nextf32(&rng)*2.0f - 1.0f)*range;
+      if ((idx % 7) == 3)
+      {
+        x[idx] = target.x;
+        y[idx] = target.y;
+      }
+    }
+    
+    v2f_batch_step_toward_fast(step_x, step_y, x, y, target, step, count);
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      f64 to_x = (f64)(target.x - x[idx]);
+      f64 to_y = (f64)(target.y - y[idx]);
+      f64 length = sqrt(to_x*to_x + to_y*to_y);
+      if (length < 0.00005)
+      {
+        zeros_matched &= (step_x[idx] == 0.0f) && (step_y[idx] == 0.0f);
+      }
+      else if (length > 0.0002)
+      {
+        f64 error_x = fabs((f64)step_x[idx] - to_x / length * step);
+        f64 error_y = fabs((f64)step_y[idx] - to_y / length * step);
+        max_error = Max(max_error, Max(error_x, error_y) / step);
+        
+        v3f scalar = v3f_sub_and_normalize_or_zero(v3f_make(target.x, target.y, 0.0f), v3f_make(x[idx], y[idx], 0.0f));
+        steps_matched &= (fabsf(step_x[idx] - scalar.x*step) <= 1e-5f*step) && (fabsf(step_y[idx] - scalar.y*step) <= 1e-5f*step);
+      }
+    }
+    m_arena_pop_to(arena, pos);
+  }
+  TestCheck(steps_matched);
+  TestCheck(zeros_matched);
+  // NOTE(cj): the rsqrt bound, plus a couple of roundings in the subtraction and
+  // the multiplies
+  TestCheck(max_error <= Test_RSqrtBound + 5.0e-7);
+  
+  m_arena_release(arena);
+}
+
+no_inline function void
+bench_crt_sincos(f32 *sin_out, f32 *cos_out, f32 *x, u64 count)
+{
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    sin_out[idx] = sinf(x[idx]);
+    cos_out[idx] = cosf(x[idx]);
+  }
+}
+
+no_inline function void
+bench_fast_sincos(f32 *sin_out, f32 *cos_out, f32 *x, u64 count)
+{
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    f32_sincos_fast(x[idx], sin_out + idx, cos_out + idx);
+  }
+}
+
+no_inline function void
+bench_crt_rsqrt(f32 *dest, f32 *unused, f32 *x, u64 count)
+{
+  (void)unused;
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    dest[idx] = 1.0f / sqrtf(x[idx]);
+  }
+}
+
+no_inline function void
+bench_fast_rsqrt(f32 *dest, f32 *unused, f32 *x, u64 count)
+{
+  (void)unused;
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    dest[idx] = f32_rsqrt_fast(x[idx]);
+  }
+}
+
+no_inline function void
+bench_batch_rsqrt(f32 *dest, f32 *unused, f32 *x, u64 count)
+{
+  (void)unused;
+  f32_batch_rsqrt_fast(dest, x, count);
+}
+
+function void
+bench_fast_math(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  printf("\n== fast math accuracy (%s): max error against libm in double, over a sweep of f32 inputs and their negations\n", lanes_name);
+  printf("%-28s %-32s %10s %10s %10s %10s\n", "", "inputs", "samples", "sin error", "cos error", "bound");
+  
+  char *sincos_names[] = { "sinf/cosf (crt)", "f32_sincos_fast", "f32_batch_sincos_fast" };
+  for (u64 version_idx = 0; version_idx < ArrayCount(sincos_names); ++version_idx)
+  {
+    Test_SinCosError error_1000 = test_sincos_error((Test_SinCos)version_idx, 0.0f, 1000.0f, 256);
+    Test_SinCosError error_8192 = test_sincos_error((Test_SinCos)version_idx, 1000.0f, 8192.0f, 16);
+    char bound_1000[16] = "", bound_8192[16] = "";
+    if (version_idx != Test_SinCos_CRT)
+    {
+      snprintf(bound_1000, sizeof(bound_1000), "%.1e", Test_SinCosBound1000);
+      snprintf(bound_8192, sizeof(bound_8192), "%.1e", Test_SinCosBound8192);
+    }
+    printf("%-28s %-32s %10llu %10.2e %10.2e %10s\n", sincos_names[version_idx], "|x| <= 1000, every 256th",
+           (unsigned long long)error_1000.sample_count, error_1000.sin_error, error_1000.cos_error, bound_1000);
+    printf("%-28s %-32s %10llu %10.2e %10.2e %10s\n", sincos_names[version_idx], "1000 < |x| <= 8192, every 16th",
+           (unsigned long long)error_8192.sample_count, error_8192.sin_error, error_8192.cos_error, bound_8192);
+  }
+  
+  printf("%-28s %-32s %10s %10s %10s %10s\n", "", "", "", "rel error", "", "");
+  char *rsqrt_names[] = { "f32_rsqrt_fast", "f32_batch_rsqrt_fast" };
+  for (u64 version_idx = 0; version_idx < ArrayCount(rsqrt_names); ++version_idx)
+  {
+    printf("%-28s %-32s %10u %10.2e %10s %10.1e\n", rsqrt_names[version_idx], "every f32 in [1, 4)",
+           1u << 24, test_rsqrt_error((b32)version_idx), "", Test_RSqrtBound);
+  }
+  
+  printf("\n== fast math speed (%s): 4096 inputs per call, 20M total (best of 5)\n", lanes_name);
+  printf("%-28s %12s\n", "", "ns per input");
+  
+  M_Arena *arena = m_arena_reserve(MB(1));
+  u64 count = 4096;
+  u64 round_count = 5000;
+  f32 *x = M_Arena_PushArray(arena, f32, count);
+  f32 *x_positive = M_Arena_PushArray(arena, f32, count);
+  f32 *out_a = M_Arena_PushArray(arena, f32, count);
+  f32 *out_b = M_Arena_PushArray(arena, f32, count);
+  PRNG32 rng;
+  prng32_seed(&rng, 23);
+  prng32_fill_f32_01(&rng, x, count);
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    x_positive[idx] = 0.01f + x[idx]*10000.0f;
+    x[idx] = (x[idx]*2.0f - 1.0f)*100.0f;
+  }
+  
+  void (* volatile kernels[])(f32 *, f32 *, f32 *, u64) =
+  {
+    bench_crt_sincos, bench_fast_sincos, f32_batch_sincos_fast,
+    bench_crt_rsqrt, bench_fast_rsqrt, bench_batch_rsqrt,
+  };
+  char *names[] =
+  {
+    "sinf + cosf (crt)", "f32_sincos_fast", "f32_batch_sincos_fast",
+    "1/sqrtf", "f32_rsqrt_fast", "f32_batch_rsqrt_fast",
+  };
+  for (u64 kernel_idx = 0; kernel_idx < ArrayCount(kernels); ++kernel_idx)
+  {
+    f32 *input = (kernel_idx < 3) ? x : x_positive;
+    f64 best_secs = 1e9;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        kernels[kernel_idx](out_a, out_b, input, count);
+      }
+      best_secs = Min(best_secs, test_seconds() - start);
+      g_bench_sink += (u64)(out_a[count - 1]*1000.0f);
+    }
+    printf("%-28s %12.3f\n", names[kernel_idx], best_secs / (f64)(count*round_count) * 1e9);
+  }
+  m_arena_release(arena);
+}
+
+// NOTE(cj): the chase step for every chaser: the exact and the _fast scalar
+// normalize per element (the per entity loop), then the batch kernel
+no_inline function void
+bench_step_toward_exact(f32 *dest_x, f32 *dest_y, f32 *x, f32 *y, v2f target, f32 step, u64 count)
+{
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    v3f to_target = v3f_sub_and_normalize_or_zero(v3f_make(target.x, target.y, 0.0f), v3f_make(x[idx], y[idx], 0.0f));
+    dest_x[idx] = to_target.x * step;
+    dest_y[idx] = to_target.y * step;
+  }
+}
+
+no_inline function void
+bench_step_toward_scalar_fast(f32 *dest_x, f32 *dest_y, f32 *x, f32 *y, v2f target, f32 step, u64 count)
+{
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    v3f to_target = v3f_sub_and_normalize_or_zero_fast(v3f_make(target.x, target.y, 0.0f), v3f_make(x[idx], y[idx], 0.0f));
+    dest_x[idx] = to_target.x * step;
+    dest_y[idx] = to_target.y * step;
+  }
+}
+
+no_inline function void
+bench_step_toward_batch(f32 *dest_x, f32 *dest_y, f32 *x, f32 *y, v2f target, f32 step, u64 count)
+{
+  v2f_batch_step_toward_fast(dest_x, dest_y, x, y, target, step, count);
+}
+
+function void
+bench_step_toward(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  printf("\n== chase step (%s): step toward the player for every chaser, 20M per run (best of 5)\n", lanes_name);
+  printf("%8s %14s %14s %14s %9s\n", "chasers", "exact ns", "scalar fast ns", "batch ns", "speedup");
+  
+  M_Arena *arena = m_arena_reserve(MB(8));
+  PRNG32 rng;
+  prng32_seed(&rng, 22);
+  v2f target = v2f_make(37.5f, -12.25f);
+  
+  void (* volatile kernels[])(f32 *, f32 *, f32 *, f32 *, v2f, f32, u64) = { bench_step_toward_exact, bench_step_toward_scalar_fast, bench_step_toward_batch };
+  u64 counts[] = { 1000, 10000, 100000 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u64 count = counts[count_idx];
+    f32 *x = M_Arena_PushArray(arena, f32, count);
+    f32 *y = M_Arena_PushArray(arena, f32, count);
+    f32 *step_x = M_Arena_PushArray(arena, f32, count);
+    f32 *step_y = M_Arena_PushArray(arena, f32, count);
+    for (u64 idx = 0; idx < count; ++idx)
+    {
+      x[idx] = (prng32_nextf32(&rng)*2.0f - 1.0f)*5000.0f;
+      y[idx] = (prng32_nextf32(&rng)*2.0f - 1.0f)*5000.0f;
+    }
+    
+    u64 round_count = 20000000 / count;
+    f64 best_secs[3] = { 1e9, 1e9, 1e9 };
+    for (u32 run = 0; run < 5; ++run)
+    {
+      for (u64 kernel_idx = 0; kernel_idx < ArrayCount(best_secs); ++kernel_idx)
+      {
+        f64 start = test_seconds();
+        for (u64 round = 0; round < round_count; ++round)
+        {
+          kernels[kernel_idx](step_x, step_y, x, y, target, 0.5f, count);
+        }
+        best_secs[kernel_idx] = Min(best_secs[kernel_idx], test_seconds() - start);
+      }
+    }
+    g_bench_sink += (u64)(step_x[0] + step_y[count - 1]);
+    
+    f64 element_count = (f64)(round_count*count);
+    printf("%8llu %14.3f %14.3f %14.3f %8.2fx\n", (unsigned long long)count,
+           best_secs[0] / element_count * 1e9, best_secs[1] / element_count * 1e9, best_secs[2] / element_count * 1e9,
+           best_secs[1] / best_secs[2]);
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Spatial grid
+//
+typedef struct
+{
+  v2f p;
+  v2f half_dims;
+} Test_GridItem;
+
+// NOTE(cj): mostly entity sized boxes, with every 16th one several cells wide
+function Test_GridItem *
+test_push_random_grid_items(M_Arena *arena, PRNG32 *rng, u32 count, f32 range)
+{
+  Test_GridItem *result = M_Arena_PushArray(arena, Test_GridItem, count);
+  for (u32 idx = 0; idx < count; ++idx)
+  {
+    f32 max_half_dim = ((idx % 16) == 5) ? 300.0f : 40.0f;
+    result[idx].p = v2f_make((prng32_nextf32(rng)*2.0f - 1.0f)*range, (prng32_nextf32(rng)*2.0f - 1.0f)*range);
+    result[idx].half_dims = v2f_make(1.0f + prng32_nextf32(rng)*max_half_dim, 1.0f + prng32_nextf32(rng)*max_half_dim);
+  }
+  return(result);
+}
+
+function void
+test_build_grid(Spatial_Grid *grid, Test_GridItem *items, u32 count)
+{
+  spatial_grid_begin(grid, count);
+  for (u32 idx = 0; idx < count; ++idx)
+  {
+    spatial_grid_push(grid, idx, items[idx].p, items[idx].half_dims);
+  }
+  spatial_grid_end(grid);
+}
+
+function b32
+test_grid_item_in_rect(Test_GridItem *item, v2f p, v2f half_dims)
+{
+  b32 result = ((absolute_value_f32(item->p.x - p.x) <= (item->half_dims.x + half_dims.x)) &&
+                (absolute_value_f32(item->p.y - p.y) <= (item->half_dims.y + half_dims.y)));
+  return(result);
+}
+
+function f32
+test_grid_item_distance_sq(Test_GridItem *item, v2f p)
+{
+  f32 dx = item->p.x - p.x;
+  f32 dy = item->p.y - p.y;
+  f32 result = dx*dx + dy*dy;
+  return(result);
+}
+
+// NOTE(cj): results must be exactly the expected items, each once. expected is
+// cleared on the way.
+function b32
+test_grid_results_match(u32 *results, u32 result_count, b32 *expected, u32 expected_count, u32 item_count)
+{
+  b32 result = (result_count == expected_count);
+  for (u32 idx = 0; result && (idx < result_count); ++idx)
+  {
+    result = (results[idx] < item_count) && expected[results[idx]];
+    if (result)
+    {
+      expected[results[idx]] = 0;
+    }
+  }
+  MemoryClear(expected, sizeof(b32)*item_count);
+  return(result);
+}
+
+// NOTE(cj): every query against a brute force scan of the items. Items are spread
+// across the origin (cell coordinates go negative), the big ones reach several
+// cells past their own, and the grids are small enough that the big queries
+// cover more cells than there are buckets and scan every item instead.
+function void
+test_spatial_grid(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(64));
+  PRNG32 rng;
+  prng32_seed(&rng, 20);
+  
+  u32 item_counts[] = { 1, 10, 300, 3000 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(item_counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u32 item_count = item_counts[count_idx];
+    f32 range = 64.0f*sqrtf((f32)item_count) + 100.0f;
+    Test_GridItem *items = test_push_random_grid_items(arena, &rng, item_count, range);
+    Spatial_Grid grid;
+    spatial_grid_init(&grid, arena, 128.0f);
+    test_build_grid(&grid, items, item_count);
+    TestCheck(grid.count == item_count);
+    
+    b32 *expected = M_Arena_PushArray(arena, b32, item_count);
+    u32 *results = M_Arena_PushArray(arena, u32, item_count);
+    Spatial_Grid_Neighbor *neighbors = M_Arena_PushArray(arena, Spatial_Grid_Neighbor, item_count);
+    Spatial_Grid_Neighbor nearest[8];
+    
+    b32 rect_matched = 1;
+    b32 radius_matched = 1;
+    b32 nearest_matched = 1;
+    b32 truncated_matched = 1;
+    u32 scanned_all = 0;
+    u32 walked_cells = 0;
+    for (u32 query_idx = 0; query_idx < 500; ++query_idx)
+    {
+      v2f p = v2f_make((prng32_nextf32(&rng)*2.0f - 1.0f)*range*1.2f, (prng32_nextf32(&rng)*2.0f - 1.0f)*range*1.2f);
+      f32 query_scale = ((query_idx % 8) == 0) ? range*2.0f : 200.0f;
+      v2f half_dims = v2f_make(prng32_nextf32(&rng)*query_scale, prng32_nextf32(&rng)*query_scale);
+      f32 radius = prng32_nextf32(&rng)*query_scale;
+      u32 skip_value = prng32_rangeu32(&rng, 0, item_count + 1);
+      v2f reach = v2f_make(half_dims.x + grid.max_half_dim_x, half_dims.y + grid.max_half_dim_y);
+      s64 cells_x = spatial_grid_cell_coord(&grid, p.x + reach.x) - spatial_grid_cell_coord(&grid, p.x - reach.x) + 1;
+      s64 cells_y = spatial_grid_cell_coord(&grid, p.y + reach.y) - spatial_grid_cell_coord(&grid, p.y - reach.y) + 1;
+      if ((u64)(cells_x*cells_y) > grid.bucket_count)
+      {
+        scanned_all += 1;
+      }
+      else
+      {
+        walked_cells += 1;
+      }
+      
+      u32 expected_count = 0;
+      for (u32 idx = 0; idx < item_count; ++idx)
+      {
+        expected[idx] = test_grid_item_in_rect(items + idx, p, half_dims);
+        expected_count += expected[idx];
+      }
+      u32 result_count = spatial_grid_query_rect(&grid, p, half_dims, results, item_count);
+      rect_matched &= test_grid_results_match(results, result_count, expected, expected_count, item_count);
+      
+      if (expected_count > 1)
+      {
+        truncated_matched &= (spatial_grid_query_rect(&grid, p, half_dims, results, 1) == expected_count);
+      }
+      
+      expected_count = 0;
+      u32 neighbor_count = 0;
+      for (u32 idx = 0; idx < item_count; ++idx)
+      {
+        f32 distance_sq = test_grid_item_distance_sq(items + idx, p);
+        expected[idx] = (distance_sq <= radius*radius);
+        expected_count += expected[idx];
+        if (expected[idx] && (idx != skip_value))
+        {
+          neighbors[neighbor_count++].distance_sq = distance_sq;
+        }
+      }
+      result_count = spatial_grid_query_radius(&grid, p, radius, results, item_count);
+      radius_matched &= test_grid_results_match(results, result_count, expected, expected_count, item_count);
+      
+      // NOTE(cj): the nearest ones are the expected distances, smallest first. Ties
+      // can come in either order, so only the distances are compared.
+      for (u32 idx = 1; idx < neighbor_count; ++idx)
+      {
+        Spatial_Grid_Neighbor neighbor = neighbors[idx];
+        u32 insert_idx = idx;
+        while ((insert_idx > 0) && (neighbors[insert_idx - 1].distance_sq > neighbor.distance_sq))
+        {
+          neighbors[insert_idx] = neighbors[insert_idx - 1];
+          --insert_idx;
+        }
+        neighbors[insert_idx] = neighbor;
+      }
+      result_count = spatial_grid_query_nearest(&grid, p, radius, skip_value, nearest, ArrayCount(nearest));
+      nearest_matched &= (result_count == Min(neighbor_count, ArrayCount(nearest)));
+      for (u32 idx = 0; nearest_matched && (idx < result_count); ++idx)
+      {
+        Spatial_Grid_Neighbor *neighbor = nearest + idx;
+        nearest_matched &= (neighbor->value < item_count) && (neighbor->value != skip_value);
+        nearest_matched &= (neighbor->distance_sq == neighbors[idx].distance_sq);
+        nearest_matched &= (neighbor->distance_sq == test_grid_item_distance_sq(items + neighbor->value, p));
+        nearest_matched &= (neighbor->p.x == items[neighbor->value].p.x) && (neighbor->p.y == items[neighbor->value].p.y);
+      }
+    }
+    TestCheck(rect_matched);
+    TestCheck(radius_matched);
+    TestCheck(nearest_matched);
+    TestCheck(truncated_matched);
+    TestCheck(scanned_all > 0);
+    TestCheck(walked_cells > 0);
+    
+    // NOTE(cj): pushing past the expected count only makes the buckets longer
+    spatial_grid_begin(&grid, 1);
+    for (u32 idx = 0; idx < item_count; ++idx)
+    {
+      spatial_grid_push(&grid, idx, items[idx].p, items[idx].half_dims);
+    }
+    spatial_grid_end(&grid);
+    TestCheck(grid.bucket_count == SpatialGrid_MinBucketCount);
+    u32 all_count = spatial_grid_query_rect(&grid, v2f_zero(), v2f_make(range*2.0f, range*2.0f), results, item_count);
+    TestCheck(all_count == item_count);
+    u32 first_count = spatial_grid_query_rect(&grid, items[0].p, v2f_zero(), results, item_count);
+    b32 found_first = 0;
+    for (u32 idx = 0; idx < Min(first_count, item_count); ++idx)
+    {
+      found_first |= (results[idx] == 0);
+    }
+    TestCheck(found_first);
+    
+    m_arena_pop_to(arena, pos);
+  }
+  
+  // NOTE(cj): an empty grid finds nothing
+  Spatial_Grid grid;
+  spatial_grid_init(&grid, arena, 128.0f);
+  spatial_grid_begin(&grid, 0);
+  spatial_grid_end(&grid);
+  u32 result;
+  Spatial_Grid_Neighbor neighbor;
+  TestCheck(spatial_grid_query_rect(&grid, v2f_zero(), v2f_make(10.0f, 10.0f), &result, 1) == 0);
+  TestCheck(spatial_grid_query_radius(&grid, v2f_zero(), 10.0f, &result, 1) == 0);
+  TestCheck(spatial_grid_query_nearest(&grid, v2f_zero(), 10.0f, 0, &neighbor, 1) == 0);
+  
+  m_arena_release(arena);
+}
+
+// NOTE(cj): a rebuild, then the queries a step makes: an entity sized rect, the
+// separation radius and nearest neighbors, each from 1000 items' positions, next
+// to the same rect query as a scan over every item. Items are spread at the same
+// density whatever their count.
+function void
+bench_spatial_grid_query(void)
+{
+  printf("\n== spatial grid: 128 cells, ns per build item / per query (best of 5)\n");
+  printf("%8s %10s %10s %10s %10s %12s %9s\n", "items", "build", "rect", "radius", "nearest", "scan rect", "speedup");
+  
+  M_Arena *arena = m_arena_reserve(MB(64));
+  PRNG32 rng;
+  prng32_seed(&rng, 21);
+  
+  u32 counts[] = { 100, 1000, 10000, 100000 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u32 count = counts[count_idx];
+    Test_GridItem *items = test_push_random_grid_items(arena, &rng, count, 48.0f*sqrtf((f32)count));
+    for (u32 idx = 0; idx < count; ++idx)
+    {
+      items[idx].half_dims = v2f_make(32.0f, 32.0f);
+    }
+    Spatial_Grid grid;
+    spatial_grid_init(&grid, arena, 128.0f);
+    u32 results[256];
+    Spatial_Grid_Neighbor neighbors[7];
+    u32 query_count = 1000;
+    u64 build_rounds = Max(1000000 / count, 5);
+    u64 scan_rounds = Max(1000000 / ((u64)count*query_count), 1);
+    
+    f64 best_secs[5] = { 1e9, 1e9, 1e9, 1e9, 1e9 };
+    u64 sink = 0;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < build_rounds; ++round)
+      {
+        test_build_grid(&grid, items, count);
+        sink += grid.bucket_start[1];
+      }
+      best_secs[0] = Min(best_secs[0], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u32 query_idx = 0; query_idx < query_count; ++query_idx)
+      {
+        sink += spatial_grid_query_rect(&grid, items[query_idx % count].p, v2f_make(24.0f, 24.0f), results, ArrayCount(results));
+      }
+      best_secs[1] = Min(best_secs[1], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u32 query_idx = 0; query_idx < query_count; ++query_idx)
+      {
+        sink += spatial_grid_query_radius(&grid, items[query_idx % count].p, 48.0f, results, ArrayCount(results));
+      }
+      best_secs[2] = Min(best_secs[2], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u32 query_idx = 0; query_idx < query_count; ++query_idx)
+      {
+        sink += spatial_grid_query_nearest(&grid, items[query_idx % count].p, 48.0f, query_idx % count, neighbors, ArrayCount(neighbors));
+      }
+      best_secs[3] = Min(best_secs[3], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < scan_rounds; ++round)
+      {
+        for (u32 query_idx = 0; query_idx < query_count; ++query_idx)
+        {
+          v2f p = items[query_idx % count].p;
+          for (u32 idx = 0; idx < count; ++idx)
+          {
+            sink += test_grid_item_in_rect(items + idx, p, v2f_make(24.0f, 24.0f));
+          }
+        }
+      }
+      best_secs[4] = Min(best_secs[4], test_seconds() - start);
+    }
+    g_bench_sink += sink;
+    
+    f64 scan_ns = best_secs[4] / (f64)(scan_rounds*query_count) * 1e9;
+    f64 rect_ns = best_secs[1] / (f64)query_count * 1e9;
+    printf("%8u %10.2f %10.1f %10.1f %10.1f %12.1f %8.1fx\n", count,
+           best_secs[0] / (f64)(build_rounds*count) * 1e9, rect_ns,
+           best_secs[2] / (f64)query_count * 1e9, best_secs[3] / (f64)query_count * 1e9,
+           scan_ns, scan_ns / rect_ns);
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Flow field
+//
+function u64
+test_flow_field_idx(Flow_Field *field, s32 cell_x, s32 cell_y)
+{
+  u64 result = (u64)(cell_y + 1) * field->stride + (u64)(cell_x + 1);
+  return(result);
+}
+
+function v2f
+test_flow_field_cell_center(Flow_Field *field, s32 cell_x, s32 cell_y)
+{
+  v2f result = v2f_make(((f32)(field->origin_cell_x + cell_x) + 0.5f) * field->cell_size,
+                        ((f32)(field->origin_cell_y + cell_y) + 0.5f) * field->cell_size);
+  return(result);
+}
+
+// NOTE(cj): walks from every open cell along the sampled directions, one cell at
+// a time. Every reachable cell has to get to the target in exactly its cost in
+// steps (never through a blocked cell), every cut off one has no direction.
+function b32
+test_flow_field_walks(Flow_Field *field)
+{
+  b32 result = 1;
+  for (s32 cell_y = 0; cell_y < (s32)field->height; ++cell_y)
+  {
+    for (s32 cell_x = 0; cell_x < (s32)field->width; ++cell_x)
+    {
+      f32 cost = field->cost[test_flow_field_idx(field, cell_x, cell_y)];
+      if (cost >= FlowField_BlockedCost)
+      {
+        continue;
+      }
+      
+      v2f direction;
+      s32 x = cell_x;
+      s32 y = cell_y;
+      u32 step_count = 0;
+      while (flow_field_sample(field, test_flow_field_cell_center(field, x, y), &direction) && (step_count <= 2*cost))
+      {
+        x += (direction.x > 0.0f) - (direction.x < 0.0f);
+        y += (direction.y > 0.0f) - (direction.y < 0.0f);
+        result &= !field->blocked[test_flow_field_idx(field, x, y)];
+        // NOTE(cj): a diagonal step covers two of the 4-connected steps
+        step_count += ((direction.x != 0.0f) && (direction.y != 0.0f)) ? 2 : 1;
+      }
+      
+      b32 at_target = ((field->origin_cell_x + x) == field->target_cell_x) && ((field->origin_cell_y + y) == field->target_cell_y);
+      if (cost < FlowField_Unreachable)
+      {
+        result &= at_target && ((f32)step_count == cost);
+      }
+      else
+      {
+        result &= (step_count == 0) && !at_target;
+      }
+    }
+  }
+  return(result);
+}
+
+function void
+test_flow_field(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(4));
+  Flow_Field field;
+  flow_field_init(&field, arena, 37, 29, 32.0f);
+  
+  // NOTE(cj): open field: the cost is the 4-connected distance to the target
+  v2f target = v2f_make(100.0f, -50.0f);
+  flow_field_begin(&field, target);
+  flow_field_integrate(&field, target);
+  TestCheck(field.valid);
+  TestCheck(flow_field_is_current(&field, target));
+  TestCheck(flow_field_is_current(&field, v2f_make(target.x + 20.0f, target.y)));
+  TestCheck(!flow_field_is_current(&field, v2f_make(target.x + 32.0f, target.y)));
+  b32 all_distances_matched = 1;
+  for (s32 cell_y = 0; cell_y < (s32)field.height; ++cell_y)
+  {
+    for (s32 cell_x = 0; cell_x < (s32)field.width; ++cell_x)
+    {
+      s32 dx = field.origin_cell_x + cell_x - field.target_cell_x;
+      s32 dy = field.origin_cell_y + cell_y - field.target_cell_y;
+      all_distances_matched &= (field.cost[test_flow_field_idx(&field, cell_x, cell_y)] == (f32)(abs(dx) + abs(dy)));
+    }
+  }
+  TestCheck(all_distances_matched);
+  TestCheck(test_flow_field_walks(&field));
+  
+  // NOTE(cj): the target's own cell and anything outside the window has no direction
+  v2f direction;
+  TestCheck(!flow_field_sample(&field, target, &direction));
+  TestCheck(!flow_field_sample(&field, v2f_make(target.x + 10000.0f, target.y), &direction));
+  
+  // NOTE(cj): a wall between target and the left side, with a box (closed on all
+  // four sides) whose inside is cut off. One rect hangs out of the window, which
+  // must be clipped rather than written past the arrays.
+  flow_field_begin(&field, target);
+  flow_field_block_rect(&field, v2f_make(target.x - 160.0f, target.y), v2f_make(16.0f, 300.0f));
+  flow_field_block_rect(&field, v2f_make(target.x + 320.0f, target.y + 160.0f), v2f_make(80.0f, 16.0f));
+  flow_field_block_rect(&field, v2f_make(target.x + 320.0f, target.y + 288.0f), v2f_make(80.0f, 16.0f));
+  flow_field_block_rect(&field, v2f_make(target.x + 240.0f, target.y + 224.0f), v2f_make(16.0f, 48.0f));
+  flow_field_block_rect(&field, v2f_make(target.x + 400.0f, target.y + 224.0f), v2f_make(16.0f, 48.0f));
+  flow_field_block_rect(&field, v2f_make(target.x - 100000.0f, target.y), v2f_make(16.0f, 100000.0f));
+  flow_field_integrate(&field, target);
+  TestCheck(field.valid);
+  TestCheck(test_flow_field_walks(&field));
+  
+  // NOTE(cj): behind the wall (8 cells straight across) it takes a detour, inside
+  // the box it can't get there
+  v2f behind_wall = v2f_make(target.x - 256.0f, target.y);
+  s32 behind_x = (s32)floorf(behind_wall.x / field.cell_size) - field.origin_cell_x;
+  s32 behind_y = (s32)floorf(behind_wall.y / field.cell_size) - field.origin_cell_y;
+  f32 behind_cost = field.cost[test_flow_field_idx(&field, behind_x, behind_y)];
+  TestCheck((behind_cost > 8.0f) && (behind_cost < FlowField_Unreachable));
+  v2f in_box = v2f_make(target.x + 320.0f, target.y + 224.0f);
+  s32 box_x = (s32)floorf(in_box.x / field.cell_size) - field.origin_cell_x;
+  s32 box_y = (s32)floorf(in_box.y / field.cell_size) - field.origin_cell_y;
+  TestCheck(field.cost[test_flow_field_idx(&field, box_x, box_y)] == FlowField_Unreachable);
+  TestCheck(!flow_field_sample(&field, in_box, &direction));
+  
+  // NOTE(cj): the SIMD pass has to give exactly what the scalar one gives
+  u64 padded_count = (u64)field.stride * (u64)(field.height + 2);
+  f32 *simd_dir_x = M_Arena_PushArray(arena, f32, padded_count);
+  f32 *simd_dir_y = M_Arena_PushArray(arena, f32, padded_count);
+  MemoryCopy(simd_dir_x, field.dir_x, padded_count*sizeof(f32));
+  MemoryCopy(simd_dir_y, field.dir_y, padded_count*sizeof(f32));
+  b32 all_directions_matched = 1;
+  for (s32 cell_y = 0; cell_y < (s32)field.height; ++cell_y)
+  {
+    for (s32 cell_x = 0; cell_x < (s32)field.width; ++cell_x)
+    {
+      u64 idx = test_flow_field_idx(&field, cell_x, cell_y);
+      flow_field_direction_for_cell(&field, idx);
+      all_directions_matched &= (field.dir_x[idx] == simd_dir_x[idx]) && (field.dir_y[idx] == simd_dir_y[idx]);
+    }
+  }
+  TestCheck(all_directions_matched);
+  
+  // NOTE(cj): a target inside a wall leaves the field invalid, so nothing steers
+  v2f in_wall = v2f_make(target.x - 160.0f, target.y);
+  flow_field_begin(&field, in_wall);
+  flow_field_block_rect(&field, in_wall, v2f_make(16.0f, 16.0f));
+  flow_field_integrate(&field, in_wall);
+  TestCheck(!field.valid);
+  TestCheck(!flow_field_is_current(&field, in_wall));
+  TestCheck(!flow_field_sample(&field, target, &direction));
+  
+  m_arena_release(arena);
+}
+
+// NOTE(cj): a full rebuild (begin, walls, integrate) of a window around the
+// player, the direction pass on its own next to the per cell scalar version of
+// it, and sampling. Walls are short random segments that block about a sixth of
+// the window, and the target is reachable from nearly all of the rest.
+function void
+bench_flow_field(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  printf("\n== flow field (%s): 32 unit cells, ms per rebuild / pass, ns per sample (best of 5)\n", lanes_name);
+  printf("%10s %8s %12s %12s %12s %10s\n", "cells", "walls", "rebuild ms", "dirs ms", "scalar ms", "sample ns");
+  
+  M_Arena *arena = m_arena_reserve(MB(128));
+  PRNG32 rng;
+  prng32_seed(&rng, 23);
+  
+  u32 dims[] = { 256, 1024 };
+  for (u64 dim_idx = 0; dim_idx < ArrayCount(dims); ++dim_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u32 dim = dims[dim_idx];
+    Flow_Field field;
+    flow_field_init(&field, arena, dim, dim, 32.0f);
+    f32 window_half_dim = 16.0f*(f32)dim;
+    
+    u32 wall_count = dim*dim / 80;
+    v2f *wall_p = M_Arena_PushArray(arena, v2f, wall_count);
+    v2f *wall_half_dims = M_Arena_PushArray(arena, v2f, wall_count);
+    for (u32 wall_idx = 0; wall_idx < wall_count; ++wall_idx)
+    {
+      f32 length = 32.0f + prng32_nextf32(&rng)*128.0f;
+      b32 vertical = (wall_idx & 1);
+      wall_p[wall_idx] = v2f_make((prng32_nextf32(&rng)*2.0f - 1.0f)*window_half_dim, (prng32_nextf32(&rng)*2.0f - 1.0f)*window_half_dim);
+      wall_half_dims[wall_idx] = vertical ? v2f_make(16.0f, length) : v2f_make(length, 16.0f);
+    }
+    v2f target = v2f_make(5.0f, 7.0f);
+    u32 sample_count = 1 << 16;
+    v2f *samples = M_Arena_PushArray(arena, v2f, sample_count);
+    for (u32 sample_idx = 0; sample_idx < sample_count; ++sample_idx)
+    {
+      samples[sample_idx] = v2f_make((prng32_nextf32(&rng)*2.0f - 1.0f)*window_half_dim, (prng32_nextf32(&rng)*2.0f - 1.0f)*window_half_dim);
+    }
+    
+    u64 cell_count = (u64)dim*dim;
+    u64 round_count = Max(4000000 / cell_count, 2);
+    f64 best_secs[4] = { 1e9, 1e9, 1e9, 1e9 };
+    u64 sink = 0;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        flow_field_begin(&field, target);
+        for (u32 wall_idx = 0; wall_idx < wall_count; ++wall_idx)
+        {
+          flow_field_block_rect(&field, wall_p[wall_idx], wall_half_dims[wall_idx]);
+        }
+        flow_field_integrate(&field, target);
+        sink += field.valid;
+      }
+      best_secs[0] = Min(best_secs[0], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        flow_field_compute_directions(&field);
+      }
+      best_secs[1] = Min(best_secs[1], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        for (u32 cell_y = 1; cell_y <= dim; ++cell_y)
+        {
+          for (u32 cell_x = 1; cell_x <= dim; ++cell_x)
+          {
+            flow_field_direction_for_cell(&field, (u64)cell_y*field.stride + cell_x);
+          }
+        }
+      }
+      best_secs[2] = Min(best_secs[2], test_seconds() - start);
+      
+      start = test_seconds();
+      v2f direction;
+      for (u32 sample_idx = 0; sample_idx < sample_count; ++sample_idx)
+      {
+        sink += flow_field_sample(&field, samples[sample_idx], &direction);
+      }
+      best_secs[3] = Min(best_secs[3], test_seconds() - start);
+    }
+    g_bench_sink += sink;
+    
+    printf("%4ux%-5u %8u %12.3f %12.3f %12.3f %10.2f\n", dim, dim, wall_count,
+           best_secs[0] / (f64)round_count * 1e3, best_secs[1] / (f64)round_count * 1e3,
+           best_secs[2] / (f64)round_count * 1e3, best_secs[3] / (f64)sample_count * 1e9);
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Experience gems
+//
+function u64
+test_push_gem(Experience_Gem_Table *table, f32 x, f32 y, f32 t_countdown, f32 secs_left, u32 value)
+{
+  experience_gem_table_reserve(table, table->count + 1);
+  u64 result = table->count++;
+  table->x[result] = table->prev_x[result] = x;
+  table->y[result] = table->prev_y[result] = y;
+  table->z[result] = 0.0f;
+  table->dP_x[result] = table->dP_y[result] = table->dP_z[result] = 0.0f;
+  table->t_countdown[result] = t_countdown;
+  table->countdown_secs_before_dead[result] = secs_left;
+  table->value[result] = value;
+  return(result);
+}
+
+// NOTE(cj): count gems in a box around the origin, the ones picked by
+// settled_every settled (the rest still in the air), every 16th of them dead
+function void
+test_push_random_gems(Experience_Gem_Table *table, PRNG32 *rng, u64 count, v2f half_dims, u32 settled_every)
+{
+  for (u64 idx = 0; idx < count; ++idx)
+  {
+    f32 x = (prng32_nextf32(rng)*2.0f - 1.0f)*half_dims.x;
+    f32 y = (prng32_nextf32(rng)*2.0f - 1.0f)*half_dims.y;
+    b32 settled = (prng32_nextu32(rng) % settled_every) == 0;
+    b32 dead = (prng32_nextu32(rng) % 16) == 0;
+    test_push_gem(table, x, y, settled ? 0.0f : 0.5f, dead ? 0.0f : 10.0f, ExperienceGem_Value);
+  }
+}
+
+function void
+test_gems_rebuild_grid(Experience_Gem_Table *table, Spatial_Grid *grid)
+{
+  spatial_grid_begin(grid, (u32)table->count);
+  for (u64 idx = 0; idx < table->count; ++idx)
+  {
+    spatial_grid_push(grid, (u32)idx, v2f_make(table->x[idx], table->y[idx]), v2f_zero());
+  }
+  spatial_grid_end(grid);
+}
+
+// NOTE(cj): experience_gems_find_merge_target asking the grid instead of scanning.
+// The grid returns matches in any order, so ties go to the lower index by hand.
+function u64
+test_gems_grid_merge_target(Experience_Gem_Table *table, Spatial_Grid *grid, u32 *matches, u64 gem_idx, f32 radius)
+{
+  u64 result = gem_idx;
+  f32 best_distance_sq = radius*radius;
+  u32 match_count = spatial_grid_query_radius(grid, v2f_make(table->x[gem_idx], table->y[gem_idx]), radius, matches, grid->count);
+  for (u32 match_idx = 0; match_idx < match_count; ++match_idx)
+  {
+    u64 other_idx = matches[match_idx];
+    if ((other_idx != gem_idx) && (table->t_countdown[other_idx] <= 0) && (table->countdown_secs_before_dead[other_idx] > 0))
+    {
+      f32 dx = table->x[other_idx] - table->x[gem_idx];
+      f32 dy = table->y[other_idx] - table->y[gem_idx];
+      f32 distance_sq = dx*dx + dy*dy;
+      if ((result == gem_idx) ? (distance_sq <= best_distance_sq) :
+          ((distance_sq < best_distance_sq) || ((distance_sq == best_distance_sq) && (other_idx < result))))
+      {
+        result = other_idx;
+        best_distance_sq = distance_sq;
+      }
+    }
+  }
+  return(result);
+}
+
+// NOTE(cj): experience_gems_attract asking the grid instead of scanning
+function void
+test_gems_grid_attract(Experience_Gem_Table *table, Spatial_Grid *grid, u32 *matches, v2f target, f32 radius, f32 step)
+{
+  u32 match_count = spatial_grid_query_radius(grid, target, radius, matches, grid->count);
+  for (u32 match_idx = 0; match_idx < match_count; ++match_idx)
+  {
+    u64 idx = matches[match_idx];
+    if ((table->t_countdown[idx] <= 0) && (table->countdown_secs_before_dead[idx] > 0))
+    {
+      f32 dx = target.x - table->x[idx];
+      f32 dy = target.y - table->y[idx];
+      f32 distance = sqrtf(dx*dx + dy*dy);
+      f32 scale = (distance > step) ? (step / distance) : 1.0f;
+      table->x[idx] += dx*scale;
+      table->y[idx] += dy*scale;
+    }
+  }
+}
+
+function void
+test_experience_gems(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(16));
+  Experience_Gem_Table table;
+  experience_gem_table_init(&table, arena, 4);
+  
+  // NOTE(cj): a landed gem merges into the closest settled, living gem in range
+  u64 near_idx = test_push_gem(&table, 0.0f, 0.0f, 0.0f, 5.0f, 2);
+  u64 far_idx = test_push_gem(&table, 100.0f, 0.0f, 0.0f, 1.0f, 2);
+  u64 dead_idx = test_push_gem(&table, 9.0f, 0.0f, 0.0f, 0.0f, 2);
+  u64 in_air_idx = test_push_gem(&table, 11.0f, 0.0f, 0.5f, 10.0f, 2);
+  u64 landed_idx = test_push_gem(&table, 10.0f, 0.0f, 0.0f, 15.0f, 3);
+  u64 alone_idx = test_push_gem(&table, -500.0f, 0.0f, 0.0f, 15.0f, 2);
+  table.landed[0] = (u32)landed_idx;
+  table.landed[1] = (u32)alone_idx;
+  experience_gems_merge_landed(&table, 2, 32.0f);
+  TestCheck(table.value[near_idx] == 5);
+  TestCheck(table.countdown_secs_before_dead[near_idx] == 15.0f);
+  TestCheck(table.value[landed_idx] == 0);
+  TestCheck(table.countdown_secs_before_dead[landed_idx] <= 0.0f);
+  TestCheck(table.value[far_idx] == 2);
+  TestCheck(table.value[dead_idx] == 2);
+  TestCheck(table.value[in_air_idx] == 2);
+  TestCheck(table.value[alone_idx] == 2);
+  TestCheck(table.countdown_secs_before_dead[alone_idx] == 15.0f);
+  
+  // NOTE(cj): ties go to the lower index
+  table.count = 0;
+  test_push_gem(&table, -10.0f, 0.0f, 0.0f, 5.0f, 2);
+  test_push_gem(&table, 10.0f, 0.0f, 0.0f, 5.0f, 2);
+  u64 middle_idx = test_push_gem(&table, 0.0f, 0.0f, 0.0f, 5.0f, 2);
+  TestCheck(experience_gems_find_merge_target(&table, middle_idx, 32.0f) == 0);
+  TestCheck(experience_gems_find_merge_target(&table, middle_idx, 9.0f) == middle_idx);
+  
+  // NOTE(cj): the magnet pulls settled, living gems in range by at most step,
+  // and leaves the rest alone
+  table.count = 0;
+  u64 pulled_idx = test_push_gem(&table, 50.0f, 0.0f, 0.0f, 5.0f, 2);
+  u64 snapped_idx = test_push_gem(&table, 0.0f, 3.0f, 0.0f, 5.0f, 2);
+  u64 out_of_range_idx = test_push_gem(&table, 0.0f, 97.0f, 0.0f, 5.0f, 2);
+  u64 flying_idx = test_push_gem(&table, 10.0f, 10.0f, 0.5f, 5.0f, 2);
+  u64 expired_idx = test_push_gem(&table, -10.0f, 0.0f, 0.0f, 0.0f, 2);
+  experience_gems_attract(&table, v2f_zero(), 96.0f, 6.0f);
+  TestCheck((table.x[pulled_idx] == 44.0f) && (table.y[pulled_idx] == 0.0f));
+  TestCheck((table.x[snapped_idx] == 0.0f) && (table.y[snapped_idx] == 0.0f));
+  TestCheck(table.y[out_of_range_idx] == 97.0f);
+  TestCheck((table.x[flying_idx] == 10.0f) && (table.y[flying_idx] == 10.0f));
+  TestCheck(table.x[expired_idx] == -10.0f);
+  
+  // NOTE(cj): removals are the touched and the expired gems, in ascending order
+  u64 removal_count = experience_gems_collect_removals(&table, v2f_zero(), v2f_make(8.0f, 8.0f));
+  TestCheck(removal_count == 3);
+  TestCheck((table.removals[0] == snapped_idx) && (table.removals[1] == flying_idx) &&
+            (table.removals[2] == expired_idx));
+  
+  // NOTE(cj): integrate reports every gem whose flight ends this step, in order
+  table.count = 0;
+  PRNG32 rng;
+  prng32_seed(&rng, 25);
+  for (u64 idx = 0; idx < 37; ++idx)
+  {
+    test_push_gem(&table, 0.0f, 0.0f, (f32)(idx % 3)*0.01f, 5.0f, 2);
+  }
+  u64 landed_count = experience_gems_integrate(&table, 0.015f);
+  b32 landed_matched = (landed_count == 12);
+  for (u64 idx = 0; idx < landed_count; ++idx)
+  {
+    landed_matched &= (table.landed[idx] == 3*idx + 1);
+  }
+  TestCheck(landed_matched);
+  
+  // NOTE(cj): the scans pick the same gems as asking a grid would, which is what
+  // bench_experience_gems times them against
+  Spatial_Grid grid;
+  spatial_grid_init(&grid, arena, 128.0f);
+  u64 counts[] = { 7, 100, 1003 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    table.count = 0;
+    test_push_random_gems(&table, &rng, counts[count_idx], v2f_make(256.0f, 256.0f), 2);
+    u32 *matches = M_Arena_PushArray(arena, u32, table.count);
+    test_gems_rebuild_grid(&table, &grid);
+    b32 targets_matched = 1;
+    for (u64 idx = 0; idx < table.count; ++idx)
+    {
+      targets_matched &= (experience_gems_find_merge_target(&table, idx, 32.0f) ==
+                          test_gems_grid_merge_target(&table, &grid, matches, idx, 32.0f));
+    }
+    TestCheck(targets_matched);
+    
+    f32 *scan_x = M_Arena_PushArray(arena, f32, table.count);
+    f32 *scan_y = M_Arena_PushArray(arena, f32, table.count);
+    f32 *start_x = M_Arena_PushArray(arena, f32, table.count);
+    f32 *start_y = M_Arena_PushArray(arena, f32, table.count);
+    MemoryCopy(start_x, table.x, table.count*sizeof(f32));
+    MemoryCopy(start_y, table.y, table.count*sizeof(f32));
+    experience_gems_attract(&table, v2f_make(20.0f, -30.0f), 96.0f, 6.0f);
+    MemoryCopy(scan_x, table.x, table.count*sizeof(f32));
+    MemoryCopy(scan_y, table.y, table.count*sizeof(f32));
+    MemoryCopy(table.x, start_x, table.count*sizeof(f32));
+    MemoryCopy(table.y, start_y, table.count*sizeof(f32));
+    test_gems_grid_attract(&table, &grid, matches, v2f_make(20.0f, -30.0f), 96.0f, 6.0f);
+    u64 moved_count = 0;
+    b32 attract_matched = 1;
+    for (u64 idx = 0; idx < table.count; ++idx)
+    {
+      attract_matched &= (absolute_value_f32(scan_x[idx] - table.x[idx]) <= 1e-3f) && (absolute_value_f32(scan_y[idx] - table.y[idx]) <= 1e-3f);
+      moved_count += (scan_x[idx] != start_x[idx]) || (scan_y[idx] != start_y[idx]);
+    }
+    TestCheck(attract_matched);
+    TestCheck((counts[count_idx] < 100) || moved_count);
+  }
+  
+  m_arena_release(arena);
+}
+
+// NOTE(cj): the merge and magnet passes the game runs every step, scanning vs
+// asking a grid. Gems move every step, so the grid side pays for a rebuild every
+// step too. Gems are spread over about a screen around the player with half of
+// them settled, and landed_count of them landed this step. Nothing is written
+// back (the magnet step is 0), so every round sees the same gems.
+function void
+bench_experience_gems(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  u64 landed_count = 5;
+  printf("\n== experience gems (%s): merge %llu landed gems + magnet, per step (best of 5)\n", lanes_name, (unsigned long long)landed_count);
+  printf("%8s %12s %12s %12s %9s\n", "gems", "scan us", "grid us", "(rebuild us)", "speedup");
+  
+  M_Arena *arena = m_arena_reserve(MB(64));
+  PRNG32 rng;
+  prng32_seed(&rng, 25);
+  
+  u64 counts[] = { 16, 64, 256, 1024, 4096, 16384 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    Spatial_Grid grid;
+    spatial_grid_init(&grid, arena, 128.0f);
+    Experience_Gem_Table table;
+    experience_gem_table_init(&table, arena, counts[count_idx]);
+    test_push_random_gems(&table, &rng, counts[count_idx], v2f_make(960.0f, 540.0f), 2);
+    u32 *matches = M_Arena_PushArray(arena, u32, table.count);
+    v2f player_p = v2f_make(10.0f, -20.0f);
+    
+    u64 round_count = Max(2000000 / table.count, 200);
+    f64 best_secs[3] = { 1e9, 1e9, 1e9 };
+    u64 sink = 0;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        for (u64 landed_idx = 0; landed_idx < landed_count; ++landed_idx)
+        {
+          sink += experience_gems_find_merge_target(&table, (round + landed_idx*7) % table.count, 32.0f);
+        }
+        experience_gems_attract(&table, player_p, 96.0f, 0.0f);
+      }
+      best_secs[0] = Min(best_secs[0], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        test_gems_rebuild_grid(&table, &grid);
+        for (u64 landed_idx = 0; landed_idx < landed_count; ++landed_idx)
+        {
+          sink += test_gems_grid_merge_target(&table, &grid, matches, (round + landed_idx*7) % table.count, 32.0f);
+        }
+        test_gems_grid_attract(&table, &grid, matches, player_p, 96.0f, 0.0f);
+      }
+      best_secs[1] = Min(best_secs[1], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        test_gems_rebuild_grid(&table, &grid);
+        sink += grid.count;
+      }
+      best_secs[2] = Min(best_secs[2], test_seconds() - start);
+    }
+    g_bench_sink += sink;
+    
+    printf("%8llu %12.3f %12.3f %12.3f %8.2fx\n", (unsigned long long)table.count,
+           best_secs[0] / (f64)round_count * 1e6, best_secs[1] / (f64)round_count * 1e6,
+           best_secs[2] / (f64)round_count * 1e6, best_secs[1] / best_secs[0]);
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+// NOTE(cj): a gem the way they were stored before the table: a node in a list
+// threaded through a pool
+typedef struct Bench_ListGem Bench_ListGem;
+struct Bench_ListGem
+{
+  v3f p;
+  v3f prev_p;
+  v3f dims;
+  f32 countdown_secs_before_dead;
+  
+  v3f dP;
+  f32 t_countdown;
+  b32 picked_up;
+  
+  Bench_ListGem *next;
+};
+M_DefinePoolFN(Bench_ListGem, bench_list_gem);
+
+// NOTE(cj): the per step update both layouts share: fly the gems in the air, pick
+// up the ones touching the player, drop the ones out of time and tick the rest
+// down. The list does it the way the game did, one node at a time.
+no_inline function u64
+bench_list_gems_step(Bench_ListGem **first, M_Pool *pool, v2f player_p, v2f player_half_dims, f32 dt)
+{
+  u64 result = 0;
+  f32 g = -ExperienceGem_G;
+  for (Bench_ListGem *gem = *first; gem; gem = gem->next)
+  {
+    gem->prev_p = gem->p;
+    if (gem->t_countdown > 0)
+    {
+      gem->p.x += gem->dP.x * dt;
+      gem->p.y += 0.5f*g*dt*dt + gem->dP.y*dt + gem->dP.z*dt;
+      gem->p.z += gem->dP.z * dt;
+      gem->dP.y += g*dt;
+      gem->t_countdown -= dt;
+    }
+    gem->picked_up = ((absolute_value_f32(gem->p.x - player_p.x) <= (gem->dims.x*0.5f + player_half_dims.x)) &&
+                      (absolute_value_f32(gem->p.y - player_p.y) <= (gem->dims.y*0.5f + player_half_dims.y)));
+  }
+  
+  for (Bench_ListGem **gem = first; *gem;)
+  {
+    if ((*gem)->picked_up || ((*gem)->countdown_secs_before_dead <= 0))
+    {
+      Bench_ListGem *removed = *gem;
+      *gem = removed->next;
+      bench_list_gem_pool_free(pool, removed);
+      result += ExperienceGem_Value;
+    }
+    else
+    {
+      (*gem)->countdown_secs_before_dead -= dt;
+      gem = &(*gem)->next;
+    }
+  }
+  return(result);
+}
+
+no_inline function u64
+bench_table_gems_step(Experience_Gem_Table *table, v2f player_p, v2f player_half_dims, f32 dt)
+{
+  u64 result = 0;
+  MemoryCopy(table->prev_x, table->x, table->count*sizeof(f32));
+  MemoryCopy(table->prev_y, table->y, table->count*sizeof(f32));
+  experience_gems_integrate(table, dt);
+  u64 removal_count = experience_gems_collect_removals(table, player_p, player_half_dims);
+  for (u64 removal_idx = removal_count; removal_idx > 0; --removal_idx)
+  {
+    u32 gem_idx = table->removals[removal_idx - 1];
+    result += table->value[gem_idx];
+    experience_gem_swap_remove(table, gem_idx);
+  }
+  for (u64 gem_idx = 0; gem_idx < table->count; ++gem_idx)
+  {
+    table->countdown_secs_before_dead[gem_idx] -= dt;
+  }
+  return(result);
+}
+
+// NOTE(cj): the same gems both ways, half of them in the air, spread around the
+// player and never touching it, with plenty of time left, so every step sees all
+// of them. The list is linked in random order, which is where a pool ends up
+// after a game of gems spawning and being picked up in no particular order.
+function void
+bench_gem_layout(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  printf("\n== gem layout (%s): integrate + pickup + countdown per step, list vs table, 20M gem steps per run (best of 5)\n", lanes_name);
+  printf("%8s %12s %13s %9s\n", "gems", "list ns/gem", "table ns/gem", "speedup");
+  
+  M_Arena *arena = m_arena_reserve(MB(128));
+  PRNG32 rng;
+  prng32_seed(&rng, 24);
+  f32 dt = 1.0f / (f32)Game_SimHz;
+  v2f player_p = v2f_make(0.0f, 0.0f);
+  v2f player_half_dims = v2f_make(24.0f, 24.0f);
+  
+  u64 counts[] = { 1000, 10000, 100000 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u64 count = counts[count_idx];
+    Experience_Gem_Table table;
+    experience_gem_table_init(&table, arena, count);
+    M_Pool pool;
+    m_pool_init(&pool, arena, sizeof(Bench_ListGem), 256);
+    Bench_ListGem **nodes = M_Arena_PushArray(arena, Bench_ListGem *, count);
+    for (u64 gem_idx = 0; gem_idx < count; ++gem_idx)
+    {
+      f32 x = (prng32_nextf32(&rng)*2.0f - 1.0f)*2000.0f;
+      f32 y = (prng32_nextf32(&rng)*2.0f - 1.0f)*2000.0f;
+      if ((absolute_value_f32(x) < 100.0f) && (absolute_value_f32(y) < 100.0f))
+      {
+        x += 200.0f;
+      }
+      f32 t_countdown = (gem_idx & 1) ? 1e9f : 0.0f;
+      test_push_gem(&table, x, y, t_countdown, 1e9f, ExperienceGem_Value);
+      table.dP_x[gem_idx] = prng32_nextf32(&rng) - 0.5f;
+      table.dP_y[gem_idx] = ExperienceGem_G*(1e9f*0.5f);
+      
+      Bench_ListGem *gem = bench_list_gem_pool_alloc(&pool);
+      ClearStructP(gem);
+      gem->p = gem->prev_p = v3f_make(x, y, 0.0f);
+      gem->dims = v3f_make(ExperienceGem_Dim, ExperienceGem_Dim, 0.0f);
+      gem->countdown_secs_before_dead = 1e9f;
+      gem->dP = v3f_make(table.dP_x[gem_idx], table.dP_y[gem_idx], 0.0f);
+      gem->t_countdown = t_countdown;
+      nodes[gem_idx] = gem;
+    }
+    for (u64 gem_idx = count - 1; gem_idx > 0; --gem_idx)
+    {
+      u64 swap_idx = prng32_rangeu32(&rng, 0, (u32)gem_idx + 1);
+      Bench_ListGem *temp = nodes[gem_idx];
+      nodes[gem_idx] = nodes[swap_idx];
+      nodes[swap_idx] = temp;
+    }
+    Bench_ListGem *first = 0;
+    for (u64 gem_idx = 0; gem_idx < count; ++gem_idx)
+    {
+      nodes[gem_idx]->next = first;
+      first = nodes[gem_idx];
+    }
+    
+    u64 round_count = 20000000 / count;
+    f64 best_secs[2] = { 1e9, 1e9 };
+    u64 picked_up = 0;
+    for (u32 run = 0; run < 5; ++run)
+    {
+      f64 start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        picked_up += bench_list_gems_step(&first, &pool, player_p, player_half_dims, dt);
+      }
+      best_secs[0] = Min(best_secs[0], test_seconds() - start);
+      
+      start = test_seconds();
+      for (u64 round = 0; round < round_count; ++round)
+      {
+        picked_up += bench_table_gems_step(&table, player_p, player_half_dims, dt);
+      }
+      best_secs[1] = Min(best_secs[1], test_seconds() - start);
+    }
+    Assert((picked_up == 0) && (table.count == count));
+    g_bench_sink += picked_up + (u64)table.x[0] + (u64)first->p.x;
+    
+    f64 gem_steps = (f64)(round_count*count);
+    printf("%8llu %12.3f %13.3f %8.2fx\n", (unsigned long long)count,
+           best_secs[0] / gem_steps * 1e9, best_secs[1] / gem_steps * 1e9, best_secs[0] / best_secs[1]);
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Entities
+//
+// NOTE(cj): entities remember their serial in x, to check that a handle resolves
+// to the entity it was made for
+function void
+test_entity_handles(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(64));
+  PRNG32 rng;
+  prng32_seed(&rng, 19);
+  
+  Entity_Table table;
+  entity_table_init(&table, arena, 4);
+  TestCheck(table.slot_capacity >= 4);
+  
+  // NOTE(cj): random churn, with every handle ever made kept around. Live ones
+  // resolve to their entity, removed ones never resolve again.
+  u64 made_count = 0;
+  Entity_Handle *made = M_Arena_PushArray(arena, Entity_Handle, 20000);
+  b32 *live = M_Arena_PushArray(arena, b32, 20000);
+  b32 churn_matched = 1;
+  for (u32 round = 0; round < 20000; ++round)
+  {
+    if ((table.count == 0) || (prng32_nextf32(&rng) < 0.55f))
+    {
+      u64 entity_idx = make_entity(&table, EntityType_GreenSkull, EntityFlag_Hostile);
+      table.x[entity_idx] = (f32)made_count;
+      churn_matched &= (table.handle[entity_idx] != 0);
+      live[made_count] = 1;
+      made[made_count++] = table.handle[entity_idx];
+    }
+    else
+    {
+      u64 entity_idx = prng32_rangeu32(&rng, 0, (u32)table.count);
+      live[(u64)table.x[entity_idx]] = 0;
+      entity_swap_remove(&table, entity_idx);
+    }
+    
+    if ((round % 97) == 0)
+    {
+      u64 live_count = 0;
+      for (u64 made_idx = 0; made_idx < made_count; ++made_idx)
+      {
+        u64 entity_idx = entity_index_from_handle(&table, made[made_idx]);
+        if (live[made_idx])
+        {
+          churn_matched &= (entity_idx != InvalidIndexU64) && (table.x[entity_idx] == (f32)made_idx);
+          live_count += 1;
+        }
+        else
+        {
+          churn_matched &= (entity_idx == InvalidIndexU64);
+        }
+      }
+      churn_matched &= (live_count == table.count);
+    }
+  }
+  TestCheck(churn_matched);
+  
+  // NOTE(cj): one slot made and removed over and over. A handle from its first use
+  // must not resolve again when the generation comes around (it did after 255
+  // reuses with 8 bits), and once the generation runs out the slot is retired.
+  entity_table_init(&table, arena, 4);
+  u64 first_idx = make_entity(&table, EntityType_Player, 0);
+  Entity_Handle first = table.handle[first_idx];
+  entity_swap_remove(&table, first_idx);
+  b32 stale_rejected = 1;
+  b32 same_slot = 1;
+  for (u32 reuse = 1; reuse < EntityHandle_MaxGeneration; ++reuse)
+  {
+    u64 entity_idx = make_entity(&table, EntityType_GreenSkull, EntityFlag_Hostile);
+    same_slot &= ((table.handle[entity_idx] & EntityHandle_SlotMask) == (first & EntityHandle_SlotMask));
+    stale_rejected &= (entity_index_from_handle(&table, first) == InvalidIndexU64);
+    stale_rejected &= (entity_index_from_handle(&table, table.handle[entity_idx]) == entity_idx);
+    entity_swap_remove(&table, entity_idx);
+    stale_rejected &= (entity_index_from_handle(&table, first) == InvalidIndexU64);
+  }
+  TestCheck(same_slot);
+  TestCheck(stale_rejected);
+  TestCheck(table.slot_count == 1);
+  TestCheck(table.first_free_slot == EntityHandle_NilSlot);
+  
+  u64 next_idx = make_entity(&table, EntityType_GreenSkull, EntityFlag_Hostile);
+  TestCheck((table.handle[next_idx] & EntityHandle_SlotMask) != (first & EntityHandle_SlotMask));
+  TestCheck(table.slot_count == 2);
+  TestCheck(entity_index_from_handle(&table, first) == InvalidIndexU64);
+  TestCheck(entity_index_from_handle(&table, (EntityHandle_MaxGeneration << EntityHandle_SlotBits) | (first & EntityHandle_SlotMask)) == InvalidIndexU64);
+  TestCheck(entity_index_from_handle(&table, table.handle[next_idx]) == next_idx);
+  TestCheck(entity_index_from_handle(&table, 0) == InvalidIndexU64);
+  
+  m_arena_release(arena);
+}
+
+function void
+test_push_skulls(Entity_Table *table, PRNG32 *rng, u64 count, f32 range)
+{
+  u64 player_idx = make_entity(table, EntityType_Player, 0);
+  table->half_dim_x[player_idx] = table->half_dim_y[player_idx] = 24.0f;
+  for (u64 skull_idx = 1; skull_idx < count; ++skull_idx)
+  {
+    u64 entity_idx = make_entity(table, EntityType_GreenSkull, EntityFlag_Hostile);
+    table->x[entity_idx] = (prng32_nextf32(rng)*2.0f - 1.0f)*range;
+    table->y[entity_idx] = (prng32_nextf32(rng)*2.0f - 1.0f)*range;
+    table->half_dim_x[entity_idx] = table->half_dim_y[entity_idx] = 32.0f;
+    table->max_hp[entity_idx] = table->current_hp[entity_idx] = 12.0f;
+  }
+}
+
+// NOTE(cj): an entity the way they were stored before they became a structure of
+// arrays: everything in one struct, with the type specific data in a union, so
+// that every entity is as big as the player
+typedef struct
+{
+  Entity_Type type;
+  Entity_Flag flags;
+  b32 last_face_dir;
+  v3f p;
+  v3f prev_p;
+  v3f dims;
+  f32 max_hp;
+  f32 current_hp;
+  union
+  {
+    Player player;
+    Enemy enemy;
+  };
+} Bench_AosEntity;
+
+function b32
+bench_aabb_overlap(f32 ax, f32 ay, f32 a_half_x, f32 a_half_y, f32 bx, f32 by, f32 b_half_x, f32 b_half_y)
+{
+  b32 result = ((absolute_value_f32(ax - bx) <= (a_half_x + b_half_x)) &&
+                (absolute_value_f32(ay - by) <= (a_half_y + b_half_y)));
+  return(result);
+}
+
+// NOTE(cj): one step of the skulls chasing the player and testing for contact
+// with it, the way the game did it over the AoS entities
+no_inline function u64
+bench_aos_chase_step(Bench_AosEntity *entities, u64 count, f32 step)
+{
+  u64 result = 0;
+  Bench_AosEntity *player = entities + Game_PlayerEntity;
+  for (u64 entity_idx = 1; entity_idx < count; ++entity_idx)
+  {
+    Bench_AosEntity *entity = entities + entity_idx;
+    entity->prev_p = entity->p;
+    if (!(entity->flags & EntityFlag_DeleteMe))
+    {
+      v3f to_player = v3f_sub_and_normalize_or_zero_fast(player->p, entity->p);
+      entity->p.x += to_player.x * step;
+      entity->p.y += to_player.y * step;
+    }
+    result += bench_aabb_overlap(entity->p.x, entity->p.y, entity->dims.x*0.5f, entity->dims.y*0.5f,
+                                 player->p.x, player->p.y, player->dims.x*0.5f, player->dims.y*0.5f);
+  }
+  return(result);
+}
+
+// NOTE(cj): the same step over the Entity_Table columns, the chase batched like
+// game_update does it
+no_inline function u64
+bench_soa_chase_step(Entity_Table *table, f32 *step_x, f32 *step_y, f32 step)
+{
+  u64 result = 0;
+  MemoryCopy(table->prev_x, table->x, table->count*sizeof(f32));
+  MemoryCopy(table->prev_y, table->y, table->count*sizeof(f32));
+  v2f_batch_step_toward_fast(step_x, step_y, table->x, table->y, entity_p(table, Game_PlayerEntity).xy, step, table->count);
+  f32 player_x = table->x[Game_PlayerEntity];
+  f32 player_y = table->y[Game_PlayerEntity];
+  f32 player_half_x = table->half_dim_x[Game_PlayerEntity];
+  f32 player_half_y = table->half_dim_y[Game_PlayerEntity];
+  for (u64 entity_idx = 1; entity_idx < table->count; ++entity_idx)
+  {
+    if (!(table->flags[entity_idx] & EntityFlag_DeleteMe))
+    {
+      table->x[entity_idx] += step_x[entity_idx];
+      table->y[entity_idx] += step_y[entity_idx];
+    }
+    result += bench_aabb_overlap(table->x[entity_idx], table->y[entity_idx], table->half_dim_x[entity_idx], table->half_dim_y[entity_idx],
+                                 player_x, player_y, player_half_x, player_half_y);
+  }
+  return(result);
+}
+
+// NOTE(cj): and the way the game finds contacts now: rebuild the entity grid and
+// query it around the player
+no_inline function u64
+bench_soa_grid_chase_step(Entity_Table *table, Spatial_Grid *grid, u32 *results, u32 max_results, f32 *step_x, f32 *step_y, f32 step)
+{
+  MemoryCopy(table->prev_x, table->x, table->count*sizeof(f32));
+  MemoryCopy(table->prev_y, table->y, table->count*sizeof(f32));
+  v2f_batch_step_toward_fast(step_x, step_y, table->x, table->y, entity_p(table, Game_PlayerEntity).xy, step, table->count);
+  for (u64 entity_idx = 1; entity_idx < table->count; ++entity_idx)
+  {
+    if (!(table->flags[entity_idx] & EntityFlag_DeleteMe))
+    {
+      table->x[entity_idx] += step_x[entity_idx];
+      table->y[entity_idx] += step_y[entity_idx];
+    }
+  }
+  spatial_grid_begin(grid, (u32)table->count);
+  for (u64 entity_idx = 0; entity_idx < table->count; ++entity_idx)
+  {
+    spatial_grid_push(grid, table->handle[entity_idx], v2f_make(table->x[entity_idx], table->y[entity_idx]), entity_half_dims(table, entity_idx));
+  }
+  spatial_grid_end(grid);
+  u64 result = spatial_grid_query_rect(grid, entity_p(table, Game_PlayerEntity).xy, entity_half_dims(table, Game_PlayerEntity), results, max_results);
+  return(result);
+}
+
+// NOTE(cj): skulls spread around the player at the same density whatever their
+// count, so about the same handful touch it. Every run starts from the same
+// positions.
+function void
+bench_entity_layout(void)
+{
+#if defined(DR_SIMD_AVX2)
+  char *lanes_name = "avx2";
+#elif defined(DR_SIMD_SSE2)
+  char *lanes_name = "sse2";
+#else
+  char *lanes_name = "no simd";
+#endif
+  printf("\n== entity layout (%s): skull chase + player contact, per step (best of 5)\n", lanes_name);
+  printf("%8s %9s %14s %14s %14s %9s\n", "skulls", "bytes", "AoS ns/skull", "SoA ns/skull", "grid ns/skull", "speedup");
+  
+  M_Arena *arena = m_arena_reserve(MB(256));
+  PRNG32 rng;
+  prng32_seed(&rng, 18);
+  f32 step = 32.0f / (f32)Game_SimHz;
+  
+  u64 counts[] = { 10000, 100000 };
+  for (u64 count_idx = 0; count_idx < ArrayCount(counts); ++count_idx)
+  {
+    u64 pos = m_arena_pos(arena);
+    u64 count = counts[count_idx];
+    Entity_Table table;
+    entity_table_init(&table, arena, count);
+    test_push_skulls(&table, &rng, count, 32.0f*sqrtf((f32)count));
+    Spatial_Grid grid;
+    spatial_grid_init(&grid, arena, Game_GridCellSize);
+    u32 *results = M_Arena_PushArray(arena, u32, count);
+    f32 *step_x = M_Arena_PushArray(arena, f32, count);
+    f32 *step_y = M_Arena_PushArray(arena, f32, count);
+    f32 *start_x = M_Arena_PushArray(arena, f32, count);
+    f32 *start_y = M_Arena_PushArray(arena, f32, count);
+    MemoryCopy(start_x, table.x, count*sizeof(f32));
+    MemoryCopy(start_y, table.y, count*sizeof(f32));
+    
+    Bench_AosEntity *aos = M_Arena_PushArray(arena, Bench_AosEntity, count);
+    for (u64 entity_idx = 0; entity_idx < count; ++entity_idx)
+    {
+      aos[entity_idx].type = table.type[entity_idx];
+      aos[entity_idx].flags = table.flags[entity_idx];
+      aos[entity_idx].dims = entity_dims(&table, entity_idx);
+      aos[entity_idx].max_hp = aos[entity_idx].current_hp = table.max_hp[entity_idx];
+    }
+    
+    u64 round_count = Max(2000000 / count, 20);
+    f64 best_secs[3] = { 1e9, 1e9, 1e9 };
+    u64 contacts[3] = {0};
+    for (u32 run = 0; run < 5; ++run)
+    {
+      for (u64 side = 0; side < 3; ++side)
+      {
+        MemoryCopy(table.x, start_x, count*sizeof(f32));
+        MemoryCopy(table.y, start_y, count*sizeof(f32));
+        for (u64 entity_idx = 0; entity_idx < count; ++entity_idx)
+        {
+          aos[entity_idx].p = entity_p(&table, entity_idx);
+        }
+        
+        u64 contact_count = 0;
+        f64 start = test_seconds();
+        for (u64 round = 0; round < round_count; ++round)
+        {
+          switch (side)
+          {
+            case 0: contact_count += bench_aos_chase_step(aos, count, step); break;
+            case 1: contact_count += bench_soa_chase_step(&table, step_x, step_y, step); break;
+            case 2: contact_count += bench_soa_grid_chase_step(&table, &grid, results, (u32)count, step_x, step_y, step); break;
+          }
+        }
+        best_secs[side] = Min(best_secs[side], test_seconds() - start);
+        contacts[side] = contact_count;
+      }
+    }
+    g_bench_sink += contacts[0] + contacts[1] + contacts[2];
+    
+    f64 skull_steps = (f64)(round_count*(count - 1));
+    printf("%8llu %9llu %14.3f %14.3f %14.3f %8.2fx\n", (unsigned long long)(count - 1), (unsigned long long)sizeof(Bench_AosEntity),
+           best_secs[0] / skull_steps * 1e9, best_secs[1] / skull_steps * 1e9, best_secs[2] / skull_steps * 1e9,
+           best_secs[0] / best_secs[1]);
+    m_arena_pop_to(arena, pos);
+  }
+  
+  m_arena_release(arena);
+}
+
+//
+// NOTE(cj): Scratch arenas
+//
+function void
+test_scratch_conflicts(void)
+{
+  Temporary_Memory outer = scratch_begin(0, 0);
+  TestCheck(outer.arena != 0);
+  TestCheck(outer.arena->scratch_slot == 1);
+  u64 outer_pos = m_arena_pos(outer.arena);
+  m_arena_push(outer.arena, 100);
+  
+  // NOTE(cj): passing the outer scratch (or anything of ours) as a conflict has to
+  // hand out a different one. Arenas that aren't scratch arenas don't count.
+  M_Arena *not_scratch = m_arena_reserve(KB(64));
+  M_Arena *conflicts[] = { not_scratch, outer.arena, 0 };
+  Temporary_Memory inner = scratch_begin(conflicts, ArrayCount(conflicts));
+  TestCheck(inner.arena != outer.arena);
+  TestCheck(inner.arena->scratch_slot == 2);
+  
+  M_Arena *both[] = { outer.arena, inner.arena };
+  M_Arena *third = scratch_get_arena(both, ArrayCount(both));
+  TestCheck((third != outer.arena) && (third != inner.arena));
+  TestCheck(scratch_get_arena(conflicts + 1, 1) == inner.arena);
+  scratch_end(inner);
+  
+  // NOTE(cj): ending a scratch puts its arena back where it was
+  scratch_end(outer);
+  TestCheck(m_arena_pos(outer.arena) == outer_pos);
+  
+  u64 run_count = 0;
+  ScratchScope(scratch, 0, 0)
+  {
+    TestCheck(scratch.arena == outer.arena);
+    m_arena_push(scratch.arena, 64);
+    run_count += 1;
+  }
+  TestCheck(run_count == 1);
+  TestCheck(m_arena_pos(outer.arena) == outer_pos);
+  m_arena_release(not_scratch);
+}
+
+typedef struct
+{
+  M_Arena *arenas[2];
+  b32 nested_differs;
+} Test_ScratchThreadResult;
+
+function void
+test_scratch_thread_work(Test_ScratchThreadResult *result)
+{
+  Temporary_Memory outer = scratch_begin(0, 0);
+  Temporary_Memory inner = scratch_begin(&outer.arena, 1);
+  result->arenas[0] = outer.arena;
+  result->arenas[1] = inner.arena;
+  result->nested_differs = (outer.arena != inner.arena);
+  scratch_end(inner);
+  scratch_end(outer);
+}
+
+#if defined(OS_WINDOWS)
+function DWORD WINAPI
+test_scratch_thread_proc(void *parameter)
+{
+  test_scratch_thread_work(parameter);
+  return(0);
+}
+#else
+function void *
+test_scratch_thread_proc(void *parameter)
+{
+  test_scratch_thread_work(parameter);
+  return(0);
+}
+#endif
+
+function void
+test_scratch_threads(void)
+{
+  // NOTE(cj): every thread gets its own pool, nobody hands out another thread's
+  // arenas
+  Test_ScratchThreadResult results[4] = {0};
+#if defined(OS_WINDOWS)
+  HANDLE threads[ArrayCount(results)];
+  for (u64 thread_idx = 0; thread_idx < ArrayCount(results); ++thread_idx)
+  {
+    threads[thread_idx] = CreateThread(0, 0, test_scratch_thread_proc, &results[thread_idx], 0, 0);
+  }
+  WaitForMultipleObjects(ArrayCount(threads), threads, TRUE, INFINITE);
+  for (u64 thread_idx = 0; thread_idx < ArrayCount(results); ++thread_idx)
+  {
+    CloseHandle(threads[thread_idx]);
+  }
+#else
+  pthread_t threads[ArrayCount(results)];
+  for (u64 thread_idx = 0; thread_idx < ArrayCount(results); ++thread_idx)
+  {
+    pthread_create(&threads[thread_idx], 0, test_scratch_thread_proc, &results[thread_idx]);
+  }
+  for (u64 thread_idx = 0; thread_idx < ArrayCount(results); ++thread_idx)
+  {
+    pthread_join(threads[thread_idx], 0);
+  }
+#endif
+
+  Test_ScratchThreadResult main_result;
+  test_scratch_thread_work(&main_result);
+  for (u64 thread_idx = 0; thread_idx < ArrayCount(results); ++thread_idx)
+  {
+    TestCheck(results[thread_idx].nested_differs);
+    TestCheck(results[thread_idx].arenas[0] != main_result.arenas[0]);
+    for (u64 other_idx = thread_idx + 1; other_idx < ArrayCount(results); ++other_idx)
+    {
+      TestCheck(results[thread_idx].arenas[0] != results[other_idx].arenas[0]);
+      TestCheck(results[thread_idx].arenas[1] != results[other_idx].arenas[1]);
+    }
+  }
+}
+
+//
+// NOTE(cj): M_Pool
+//
+function void
+test_pool(void)
+{
+  M_Arena *arena = m_arena_reserve(MB(8));
+  M_Pool pool;
+  m_pool_init(&pool, arena, 40, 16);
+  
+  // NOTE(cj): enough slots for a few chunks, so the index math crosses chunks
+  u8 *elements[100];
+  M_Pool_Handle handles[100];
+  for (u64 element_idx = 0; element_idx < ArrayCount(elements); ++element_idx)
+  {
+    elements[element_idx] = m_pool_alloc(&pool);
+    TestCheck(((u64)elements[element_idx] % 16) == 0);
+    memset(elements[element_idx], (int)element_idx, 40);
+    handles[element_idx] = m_pool_handle(&pool, elements[element_idx]);
+  }
+  TestCheck(pool.live_count == 100);
+  TestCheck(pool.chunk_count == 7);
+  for (u64 element_idx = 0; element_idx < ArrayCount(elements); ++element_idx)
+  {
+    TestCheck(m_pool_get(&pool, handles[element_idx]) == elements[element_idx]);
+    TestCheck(elements[element_idx][39] == (u8)element_idx);
+  }
+  
+  // NOTE(cj): freed slots come back first, and their old handles go stale
+  m_pool_free(&pool, elements[10]);
+  m_pool_free(&pool, elements[20]);
+  TestCheck(m_pool_get(&pool, handles[10]) == 0);
+  u8 *reused = m_pool_alloc(&pool);
+  TestCheck(reused == elements[20]);
+  TestCheck(m_pool_get(&pool, handles[20]) == 0);
+  TestCheck(m_pool_get(&pool, m_pool_handle(&pool, reused)) == reused);
+  TestCheck(m_pool_alloc(&pool) == elements[10]);
+  TestCheck(pool.live_count == 100);
+  
+  void *to_free[] = { elements[0], elements[50], elements[99] };
+  m_pool_free_many(&pool, to_free, ArrayCount(to_free));
+  TestCheck(pool.live_count == 97);
+  TestCheck(m_pool_get(&pool, handles[50]) == 0);
+  
+  // NOTE(cj): reset hands the slots out again in index order, without touching
+  // the arena
+  u64 arena_pos = m_arena_pos(arena);
+  m_pool_reset(&pool);
+  TestCheck(pool.live_count == 0);
+  TestCheck(m_pool_get(&pool, handles[1]) == 0);
+  for (u64 element_idx = 0; element_idx < ArrayCount(elements); ++element_idx)
+  {
+    TestCheck(m_pool_alloc(&pool) == elements[element_idx]);
+  }
+  TestCheck(m_arena_pos(arena) == arena_pos);
+  TestCheck(m_pool_get(&pool, (M_Pool_Handle){ 1000, 1 }) == 0);
+  m_arena_release(arena);
+}
+
+// NOTE(cj): the intrusive free list the gems and UI widgets had before M_Pool
+typedef struct Bench_FreeListElement Bench_FreeListElement;
+struct Bench_FreeListElement
+{
+  Bench_FreeListElement *next;
+  u8 payload[56];
+};
+
+typedef struct
+{
+  M_Arena *arena;
+  Bench_FreeListElement *free_list;
+} Bench_FreeList;
+
+function void *
+bench_free_list_alloc(Bench_FreeList *list)
+{
+  Bench_FreeListElement *result = list->free_list;
+  if (result)
+  {
+    list->free_list = result->next;
+  }
+  else
+  {
+    result = M_Arena_PushStruct(list->arena, Bench_FreeListElement);
+  }
+  return(result);
+}
+
+function void
+bench_free_list_free(Bench_FreeList *list, void *element)
+{
+  Bench_FreeListElement *free_element = element;
+  free_element->next = list->free_list;
+  list->free_list = free_element;
+}
+
+function void
+bench_pool_churn(void)
+{
+  printf("\n== pool churn: 100000 live 64 byte objects, 10M frees + allocs in random order (best of 3)\n");
+  printf("%-24s %12s %12s\n", "", "ns per pair", "reset ms");
+  
+  u64 live_count = 100000;
+  u64 churn_count = 10000000;
+  M_Arena *arena = m_arena_reserve(MB(64));
+  void **live = M_Arena_PushArray(arena, void *, live_count);
+  u32 *victims = M_Arena_PushArray(arena, u32, churn_count);
+  PRNG32 rng;
+  prng32_seed(&rng, 5);
+  prng32_fill_range_u32(&rng, victims, churn_count, 0, (u32)live_count);
+  u64 setup_pos = m_arena_pos(arena);
+  
+  // NOTE(cj): through a pointer, so neither side gets inlined into the loop
+  void *(* volatile free_list_alloc)(Bench_FreeList *) = bench_free_list_alloc;
+  void (* volatile free_list_free)(Bench_FreeList *, void *) = bench_free_list_free;
+  void *(* volatile pool_alloc)(M_Pool *) = m_pool_alloc;
+  void (* volatile pool_free)(M_Pool *, void *) = m_pool_free;
+  
+  f64 best_secs[2] = { 1e9, 1e9 };
+  f64 best_reset_secs[2] = { 1e9, 1e9 };
+  for (u32 run = 0; run < 3; ++run)
+  {
+    // NOTE(cj): free list
+    {
+      Bench_FreeList list = { arena, 0 };
+      for (u64 live_idx = 0; live_idx < live_count; ++live_idx)
+      {
+        live[live_idx] = free_list_alloc(&list);
+      }
+      
+      f64 start = test_seconds();
+      for (u64 churn_idx = 0; churn_idx < churn_count; ++churn_idx)
+      {
+        free_list_free(&list, live[victims[churn_idx]]);
+        u8 *element = free_list_alloc(&list);
+        element[8] = (u8)churn_idx;
+        live[victims[churn_idx]] = element;
+      }
+      best_secs[0] = Min(best_secs[0], test_seconds() - start);
+      
+      // NOTE(cj): there is no reset, everything goes back one by one
+      start = test_seconds();
+      for (u64 live_idx = 0; live_idx < live_count; ++live_idx)
+      {
+        free_list_free(&list, live[live_idx]);
+      }
+      best_reset_secs[0] = Min(best_reset_secs[0], test_seconds() - start);
+      g_bench_sink += (u64)list.free_list;
+      m_arena_pop_to(arena, setup_pos);
+    }
+    
+    // NOTE(cj): M_Pool
+    {
+      M_Pool pool;
+      // NOTE(cj): 48 bytes + the slot header is the same 64 byte stride
+      m_pool_init(&pool, arena, 48, 1024);
+      for (u64 live_idx = 0; live_idx < live_count; ++live_idx)
+      {
+        live[live_idx] = pool_alloc(&pool);
+      }
+      
+      f64 start = test_seconds();
+      for (u64 churn_idx = 0; churn_idx < churn_count; ++churn_idx)
+      {
+        pool_free(&pool, live[victims[churn_idx]]);
+        u8 *element = pool_alloc(&pool);
+        element[0] = (u8)churn_idx;
+        live[victims[churn_idx]] = element;
+      }
+      best_secs[1] = Min(best_secs[1], test_seconds() - start);
+      
+      start = test_seconds();
+      m_pool_reset(&pool);
+      best_reset_secs[1] = Min(best_reset_secs[1], test_seconds() - start);
+      g_bench_sink += pool.live_count;
+      m_arena_pop_to(arena, setup_pos);
+    }
+  }
+  
+  printf("%-24s %12.2f %12.3f\n", "intrusive free list", best_secs[0] / (f64)churn_count * 1e9, best_reset_secs[0] * 1000.0);
+  printf("%-24s %12.2f %12.3f\n", "M_Pool", best_secs[1] / (f64)churn_count * 1e9, best_reset_secs[1] * 1000.0);
+  m_arena_release(arena);
+}
+
+// NOTE(cj): a frame loop whose scratch use swings between a small and a large
+// frame, like the game's does when a wave spawns. Counts the os calls with the
+// pop-time decommit and with the per-frame hysteresis.
+function void
+bench_arena_frame_loop(void)
+{
+  printf("\n== arena frame loop: 10000 frames, 64KB per frame, 3MB every 7th frame\n");
+  printf("%-24s %10s %10s %12s %10s\n", "", "commits", "decommits", "page faults", "ms");
+  
+  u32 window_sets[] = { 0, 120 };
+  for (u64 window_idx = 0; window_idx < ArrayCount(window_sets); ++window_idx)
+  {
+    M_Arena *arena = m_arena_reserve(MB(8));
+    m_arena_set_decommit_hysteresis(arena, window_sets[window_idx], 0);
+    u64 pos = m_arena_pos(arena);
+    
+    f64 start = test_seconds();
+    for (u32 frame = 0; frame < 10000; ++frame)
+    {
+      u64 frame_size = ((frame % 7) == 0) ? MB(3) : KB(64);
+      u8 *memory = m_arena_push(arena, frame_size);
+      for (u64 offset = 0; offset < frame_size; offset += KB(4))
+      {
+        memory[offset] = (u8)frame;
+      }
+      m_arena_pop_to(arena, pos);
+      m_arena_end_frame(arena);
+    }
+    f64 secs = test_seconds() - start;
+    
+    char name[32];
+    snprintf(name, sizeof(name), window_sets[window_idx] ? "hysteresis %u frames" : "decommit on pop", window_sets[window_idx]);
+    printf("%-24s %10llu %10llu %12llu %10.2f\n", name,
+           (unsigned long long)arena->stats.commit_count, (unsigned long long)arena->stats.decommit_count,
+           (unsigned long long)arena->stats.page_fault_count, secs * 1000.0);
+    m_arena_release(arena);
+  }
+}
+
+// NOTE(cj): push throughput, and the dTLB misses of touching the memory in a
+// random order afterwards, with and without large pages
+function void
+bench_arena_pages(void)
+{
+  printf("\n== arena pages: push 512MB in 256 byte pushes, then 16M random 8 byte reads\n");
+  printf("%-28s %10s %12s %14s\n", "", "push GB/s", "read ns", "dTLB misses");
+  
+  u64 total_size = MB(512);
+  u64 push_size = 256;
+  u64 read_count = 16*1024*1024;
+  M_Arena_Flag flag_sets[] = { 0, M_ArenaFlag_LargePages };
+  for (u64 flag_idx = 0; flag_idx < ArrayCount(flag_sets); ++flag_idx)
+  {
+    M_Arena *arena = m_arena_reserve_flags(total_size + MB(4), flag_sets[flag_idx]);
+    if (!arena)
+    {
+      printf("reserve failed\n");
+      continue;
+    }
+    
+    f64 push_start = test_seconds();
+    u8 *base = 0;
+    for (u64 pushed = 0; pushed < total_size; pushed += push_size)
+    {
+      u8 *block = m_arena_push(arena, push_size);
+      // NOTE(cj): one write per push, so the page faults are part of the cost
+      block[0] = (u8)pushed;
+      if (!base)
+      {
+        base = block;
+      }
+    }
+    f64 push_secs = test_seconds() - push_start;
+    
+    PRNG32 rng;
+    prng32_seed(&rng, 1234);
+    u64 sum = 0;
+    Test_Counter counter = test_counter_begin_dtlb_misses();
+    f64 read_start = test_seconds();
+    for (u64 read_idx = 0; read_idx < read_count; ++read_idx)
+    {
+      u64 offset = (((u64)prng32_nextu32(&rng) << 8) % total_size) & ~7llu;
+      sum += *(u64 *)(base + offset);
+    }
+    f64 read_secs = test_seconds() - read_start;
+    u64 misses = test_counter_end(counter);
+    g_bench_sink += sum;
+    
+    char *name = "4KB pages";
+    if (flag_sets[flag_idx] & M_ArenaFlag_LargePages)
+    {
+      name = (arena->flags & M_ArenaFlag_NoDecommit) ? "large pages (os pool)" : "large pages (transparent)";
+    }
+    
+    char misses_text[32] = "unavailable";
+    if (misses != InvalidIndexU64)
+    {
+      snprintf(misses_text, sizeof(misses_text), "%llu", (unsigned long long)misses);
+    }
+    printf("%-28s %10.2f %12.2f %14s\n", name, (f64)total_size / push_secs * 1e-9, read_secs / (f64)read_count * 1e9, misses_text);
+    
+    m_arena_release(arena);
+  }
+}
+
+int
+main(int argument_count, char **arguments)
+{
+  b32 run_benchmarks = (argument_count > 1) && !strcmp(arguments[1], "bench");
+  
+  test_arena_os();
+  test_arena_decommit_hysteresis();
+  test_arena_telemetry();
+  test_arena_chained_pop();
+  test_pool();
+  test_scratch_conflicts();
+  test_scratch_threads();
+  test_dynamic_array();
+  test_hash_map();
+  test_ui_intern();
+  test_string_search_fuzz();
+  test_string_hash();
+  test_format();
+  test_prng_fill();
+  test_prng_advance();
+  test_batch_math();
+  test_fast_math();
+  test_step_toward();
+  test_spatial_grid();
+  test_flow_field();
+  test_experience_gems();
+  test_entity_handles();
+  
+  if (run_benchmarks)
+  {
+    bench_arena_pages();
+    bench_arena_frame_loop();
+    bench_arena_push_pop();
+    bench_pool_churn();
+    bench_hash_map_vs_chained();
+    bench_string_search();
+    bench_string_hash();
+    bench_format();
+    bench_prng_fill();
+    bench_batch_math();
+    bench_fast_math();
+    bench_step_toward();
+    bench_spatial_grid_query();
+    bench_flow_field();
+    bench_experience_gems();
+    bench_gem_layout();
+    bench_entity_layout();
+  }
+  
+  printf("\n%llu checks, %llu failed\n", (unsigned long long)g_test_check_count, (unsigned long long)g_test_failure_count);
+  return(g_test_failure_count ? 1 : 0);
+}
@@ -131,8 +131,8 @@ ui_query_string_dims(R_Font font, String_U8_Const str)
 function v2f
 ui_query_string_dimsf(R_Font font, String_U8_Const str, ...)
 {
-  M_Arena *temp_arena = get_transient_arena(0, 0);
-  Temporary_Memory temp = begin_temporary_memory(temp_arena);
+  Temporary_Memory temp = scratch_begin(0, 0);
+  M_Arena *temp_arena = temp.arena;
   
   va_list args;
   va_start(args, str);
@@ -156,15 +156,15 @@ ui_query_string_dimsf(R_Font font, String_U8_Const str, ...)
     }
   }
   
-  end_temporary_memory(temp);
+  scratch_end(temp);
   return(final_dims);
 }
 
 function v2f
 ui_add_stringf(R_UI_QuadArray *quads, R_Font *font, v2f p, v4f colour, String_U8_Const str, ...)
 {
-  M_Arena *temp_arena = get_transient_arena(0, 0);
-  Temporary_Memory temp = begin_temporary_memory(temp_arena);
+  Temporary_Memory temp = scratch_begin(0, 0);
+  M_Arena *temp_arena = temp.arena;
   
   va_list args;
   va_start(args, str);
@@ -198,7 +198,7 @@ ui_add_stringf(R_UI_QuadArray *quads, R_Font *font, v2f p, v4f colour, String_U8
     pen_p.x += glyph.advance;
   }
   
-  end_temporary_memory(temp);
+  scratch_end(temp);
   return(final_dims);
 }
 
@@ -341,14 +341,18 @@ ui_progression(UI_Widget_ProgressionFlag flags, UI_AxisType direction, f32 curre
 function UI_Context *
 ui_create_context(OS_Input *input, R_UI_QuadArray *quads, R_Font font, R_Texture2D sprite_sheet)
 {
-  M_Arena *arena = m_arena_reserve(MB(2));
+  M_Arena *arena = m_arena_reserve_flags(MB(2), M_ArenaFlag_Chained);
   UI_Context *result = M_Arena_PushStruct(arena, UI_Context);
   result->arena = arena;
-  result->front_util_arena = m_arena_reserve(KB(64));
-  result->back_util_arena = m_arena_reserve(KB(64));
+  m_arena_set_name(result->arena, str8("UI"));
   
   result->root = 0;
-  result->free_widgets = 0;
+  m_pool_init(&result->widget_pool, arena, sizeof(UI_Widget), 64);
+  ui_intern_entry_array_init(&result->interns, arena, 256);
+  ui_intern_map_init(&result->intern_map, arena, 256);
+  
+  // NOTE(cj): entry 0 is the nil handle
+  MemoryClear(ui_intern_entry_array_push(&result->interns), sizeof(UI_Intern_Entry));
   result->current_build_index = 0;
   result->input = input;
   result->quads = quads;
@@ -360,15 +364,6 @@ ui_create_context(OS_Input *input, R_UI_QuadArray *quads, R_Font font, R_Texture
   return(result);
 }
 
-function UI_Key
-ui_calculate_key_from_identifier(String_U8_Const identifier)
-{
-  u64 key = str8_calculate_hash(identifier, 0);
-  UI_Key result;
-  result.key = key;
-  return(result);
-}
-
 function String_U8_Const
 ui_extract_content_from_identifier(String_U8_Const identifier)
 {
@@ -382,33 +377,168 @@ ui_extract_content_from_identifier(String_U8_Const identifier)
   return(identifier);
 }
 
-function UI_Widget *
-ui_push_widget(UI_Context *ctx, String_U8_Const identifier, UI_Widget_Flag flags)
+// NOTE(cj): buffers come in power of two sizes starting at UI_InternBufferMinSize.
+// A freed buffer goes on the free list for its size, with the link stored in
+// its first bytes.
+function u8 *
+ui_intern_alloc_buffer(UI_Context *ctx, u64 count, u64 *cap)
 {
-  UI_Key key = ui_calculate_key_from_identifier(identifier);
-  u64 cache_idx = key.key & (UI_CacheSize - 1);
+  u8 *result = 0;
+  u64 size = UI_InternBufferMinSize;
+  u64 size_class = 0;
+  while ((size < count) && (size_class < UI_InternBufferClassCount))
+  {
+    size *= 2;
+    size_class += 1;
+  }
   
-  UI_Widget *result = ctx->cache[cache_idx];
-  while (result && !str8_equal_strings(result->str8_identifier, identifier))
+  if (size_class < UI_InternBufferClassCount)
   {
-    result = result->next_in_hash;
+    result = ctx->free_intern_buffers[size_class];
+    if (result)
+    {
+      MemoryCopy(&ctx->free_intern_buffers[size_class], result, sizeof(u8 *));
+    }
+    else
+    {
+      result = M_Arena_PushArray(ctx->arena, u8, size);
+    }
+    *cap = size;
+  }
+  else
+  {
+    // NOTE(cj): too big to bother reusing
+    result = M_Arena_PushArray(ctx->arena, u8, count);
+    *cap = count;
   }
   
-  if (!result)
+  return(result);
+}
+
+function void
+ui_intern_free_buffer(UI_Context *ctx, u8 *buffer, u64 cap)
+{
+  u64 size = UI_InternBufferMinSize;
+  for (u64 size_class = 0; size_class < UI_InternBufferClassCount; ++size_class, size *= 2)
+  {
+    if (cap == size)
+    {
+      MemoryCopy(buffer, &ctx->free_intern_buffers[size_class], sizeof(u8 *));
+      ctx->free_intern_buffers[size_class] = buffer;
+      break;
+    }
+  }
+}
+
+function UI_Intern_Handle
+ui_intern_identifier(UI_Context *ctx, String_U8_Const identifier)
+{
+  u64 hash = str8_calculate_hash(identifier, 0);
+  UI_Intern_Handle first_with_hash = 0;
+  UI_Intern_Handle *map_value = ui_intern_map_find(&ctx->intern_map, hash);
+  if (map_value)
   {
-    if (ctx->free_widgets)
+    first_with_hash = *map_value;
+  }
+  
+  UI_Intern_Handle result = first_with_hash;
+  while (result && !str8_equal_strings(ctx->interns.v[result].identifier, identifier))
+  {
+    result = ctx->interns.v[result].next_with_hash;
+  }
+  
+  if (result)
+  {
+    ctx->frame_stats.intern_hits += 1;
+  }
+  else
+  {
+    if (ctx->first_free_intern)
     {
-      result = ctx->free_widgets;
-      ctx->free_widgets = ctx->free_widgets->next_in_free;
+      result = ctx->first_free_intern;
+      ctx->first_free_intern = ctx->interns.v[result].next_free;
     }
     else
     {
-      result = M_Arena_PushStruct(ctx->arena, UI_Widget);
+      result = (UI_Intern_Handle)ctx->interns.count;
+      ui_intern_entry_array_push(&ctx->interns);
     }
     
+    UI_Intern_Entry *entry = ctx->interns.v + result;
+    entry->identifier.s = ui_intern_alloc_buffer(ctx, identifier.count, &entry->identifier.cap);
+    entry->identifier.count = identifier.count;
+    MemoryCopy(entry->identifier.s, identifier.s, identifier.count);
+    entry->content = ui_extract_content_from_identifier(entry->identifier);
+    entry->hash = hash;
+    entry->next_with_hash = first_with_hash;
+    entry->next_free = 0;
+    entry->widget = 0;
+    ui_intern_map_insert(&ctx->intern_map, hash, result);
+    
+    ctx->frame_stats.intern_misses += 1;
+    ctx->frame_stats.bytes_copied += identifier.count;
+  }
+  
+  ctx->interns.v[result].last_touch_index = ctx->current_build_index;
+  return(result);
+}
+
+function void
+ui_intern_evict(UI_Context *ctx, UI_Intern_Handle handle)
+{
+  UI_Intern_Entry *entry = ctx->interns.v + handle;
+  
+  // NOTE(cj): unlink from the chain of entries sharing the hash
+  UI_Intern_Handle *first_with_hash = ui_intern_map_find(&ctx->intern_map, entry->hash);
+  Assert(first_with_hash);
+  if (*first_with_hash == handle)
+  {
+    if (entry->next_with_hash)
+    {
+      *first_with_hash = entry->next_with_hash;
+    }
+    else
+    {
+      ui_intern_map_remove(&ctx->intern_map, entry->hash);
+    }
+  }
+  else
+  {
+    UI_Intern_Handle prev = *first_with_hash;
+    while (ctx->interns.v[prev].next_with_hash != handle)
+    {
+      prev = ctx->interns.v[prev].next_with_hash;
+    }
+    ctx->interns.v[prev].next_with_hash = entry->next_with_hash;
+  }
+  
+  if (entry->widget)
+  {
+    ui_widget_pool_free(&ctx->widget_pool, entry->widget);
+  }
+  ui_intern_free_buffer(ctx, entry->identifier.s, entry->identifier.cap);
+  
+  MemoryClear(entry, sizeof(UI_Intern_Entry));
+  entry->next_free = ctx->first_free_intern;
+  ctx->first_free_intern = handle;
+  ctx->frame_stats.interns_evicted += 1;
+}
+
+function UI_Widget *
+ui_push_widget(UI_Context *ctx, String_U8_Const identifier, UI_Widget_Flag flags)
+{
+  UI_Intern_Handle intern = ui_intern_identifier(ctx, identifier);
+  UI_Intern_Entry *entry = ctx->interns.v + intern;
+  
+  UI_Widget *result = entry->widget;
+  if (!result)
+  {
+    result = ui_widget_pool_alloc(&ctx->widget_pool);
+    
     result->build_last_touch_index = ctx->current_build_index - 1;
     result->hot_t = result->active_t = 0.0f;
-    SLLPushFrontN(ctx->cache[cache_idx], result, next_in_hash);
+    result->intern = intern;
+    entry->widget = result;
   }
   
   if (result->build_last_touch_index != ctx->current_build_index)
@@ -422,10 +552,10 @@ ui_push_widget(UI_Context *ctx, String_U8_Const identifier, UI_Widget_Flag flags
     // NOTE(cj): else, in the cache, meaning, cached stuff that is useful for 
     // information such as user interaction, animation, etc.
     result->build_last_touch_index = ctx->current_build_index;
-    result->key = key;
+    result->key.key = entry->hash;
     result->flags = flags;
-    result->str8_identifier = str8_copy(ctx->back_util_arena, identifier);
-    result->str8_content = ui_extract_content_from_identifier(result->str8_identifier);
+    result->str8_identifier = entry->identifier;
+    result->str8_content = entry->content;
     result->rel_parent_p = v2f_make(0, 0);
     
     // TODO(cj): Should we instead let the me specify the dimensions of this
@@ -609,25 +739,18 @@ ui_begin(UI_Context *ctx, u32 reso_width, u32 reso_height, f32 dt_step_secs)
   
   ctx->dt_step_secs = dt_step_secs;
   
+  MemoryClear(&ctx->frame_stats, sizeof(ctx->frame_stats));
+  ctx->frame_start_pos = m_arena_pos(ctx->arena);
+  
   //
-  // NOTE(cj): Evict stuff in cache that are not used in the last frame 
+  // NOTE(cj): Evict identifiers (and their widgets) that were not used in the last frame 
   //
-  for (u64 idx = 0; idx < UI_CacheSize; ++idx)
+  for (UI_Intern_Handle handle = 1; handle < ctx->interns.count; ++handle)
   {
-    UI_Widget **start = ctx->cache + idx;
-    while (*start)
+    u64 last_touch_index = ctx->interns.v[handle].last_touch_index;
+    if (last_touch_index && (last_touch_index != ctx->current_build_index))
     {
-      if ((*start)->build_last_touch_index != ctx->current_build_index)
-      {
-        UI_Widget *temp = *start;
-        (*start) = (*start)->next_in_hash;
-        temp->next_in_free = ctx->free_widgets;
-        ctx->free_widgets = temp;
-      }
-      else
-      {
-        start = &((*start)->next_in_hash);
-      }
+      ui_intern_evict(ctx, handle);
     }
   }
   
@@ -749,8 +872,8 @@ ui_push_label(UI_Context *ctx, String_U8_Const str)
 function UI_Widget *
 ui_push_labelf(UI_Context *ctx, String_U8_Const str, ...)
 {
-  M_Arena *temp_arena = get_transient_arena(0, 0);
-  Temporary_Memory temp = begin_temporary_memory(temp_arena);
+  Temporary_Memory temp = scratch_begin(0, 0);
+  M_Arena *temp_arena = temp.arena;
   
   va_list args;
   va_start(args, str);
@@ -759,7 +882,7 @@ ui_push_labelf(UI_Context *ctx, String_U8_Const str, ...)
   
   UI_Widget *result = ui_push_label(ctx, format);
   
-  end_temporary_memory(temp);
+  scratch_end(temp);
   return(result);
 }
 
@@ -1042,6 +1165,6 @@ ui_end(UI_Context *ctx)
   
   // NOTE(cj): rendering
   ui_render(ctx, ctx->root);
-  m_arena_clear(ctx->front_util_arena);
-  Swap(M_Arena *, ctx->front_util_arena, ctx->back_util_arena);
+  
+  ctx->frame_stats.arena_bytes_pushed = m_arena_pos(ctx->arena) - ctx->frame_start_pos;
 }
\ No newline at end of file
@@ -116,15 +116,12 @@ struct UI_Widget
 {
   UI_Widget *parent, *next_sibling, *prev_sibling;
   UI_Widget *rightmost_child, *leftmost_child;
-  union
-  {
-    UI_Widget *next_in_free, *next_in_hash;
-  };
   
   // NOTE(cj): used for identifying/validating widgets
   u64 build_last_touch_index;
   UI_Key key;
   UI_Widget_Flag flags;
+  u32 intern;
   String_U8_Const str8_identifier;
   
   // NOTE(cj): String context
@@ -168,6 +165,42 @@ struct UI_Widget
   f32 smoothness;
 };
 
+M_DefinePoolFN(UI_Widget, ui_widget);
+
+//
+// NOTE(cj): Interned identifiers. The first time an identifier is pushed, its
+// bytes are copied into a buffer owned by the context and the "###" split is
+// done once. Every frame after that only hashes the identifier and compares it
+// against the interned bytes. An entry also owns the widget built from it, and both
+// are evicted when a frame goes by without the identifier being pushed.
+//
+#define UI_InternBufferMinSize 16
+#define UI_InternBufferClassCount 8
+typedef u32 UI_Intern_Handle; // index into UI_Context::interns, 0 is nil
+
+typedef struct
+{
+  String_U8_Const identifier; // cap is the size of the owned buffer
+  String_U8_Const content;    // points into identifier
+  u64 hash;
+  u64 last_touch_index;       // 0 when the entry is free
+  UI_Intern_Handle next_with_hash;
+  UI_Intern_Handle next_free;
+  UI_Widget *widget;
+} UI_Intern_Entry;
+
+DefineDynamicArray(UI_Intern_Entry, ui_intern_entry);
+DefineHashMapU64(UI_Intern_Handle, ui_intern);
+
+typedef struct
+{
+  u64 intern_hits;
+  u64 intern_misses;
+  u64 interns_evicted;
+  u64 bytes_copied;
+  u64 arena_bytes_pushed; // the context's arena only ever grows, so this is all it allocated
+} UI_Frame_Stats;
+
 #define UI_DefineStack(type,name) \
 type name##_stack[UI_MaxStackSize];\
 u64 name##_ptr;\
@@ -213,10 +246,9 @@ return ui_##name##_peek(ctx);\
 // - BORDER BOX (LIKE CSS) ONLY SIZING!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
 #define UI_MaxStackSize 64
-#define UI_CacheSize 128
 typedef struct
 {
-  M_Arena *arena, *front_util_arena, *back_util_arena;
+  M_Arena *arena;
   
   UI_Widget *root;
   f32 max_width;
@@ -228,9 +260,17 @@ typedef struct
   // the widget does not have any size or position yet, and hence we 
   // will recieve one frame delay the first time we call the create_widget function.
   // The layout calculation algorithm happens on ui_end. We will cache this result
-  // on this right below me.
-  UI_Widget *cache[UI_CacheSize];
-  UI_Widget *free_widgets;
+  // in the widget owned by the identifier's intern entry.
+  UI_Intern_Entry_Array interns;
+  HashMap_U64 intern_map; // hash -> first entry with that hash
+  UI_Intern_Handle first_free_intern;
+  u8 *free_intern_buffers[UI_InternBufferClassCount];
+  M_Pool widget_pool;
+  
+  // NOTE(cj): filled in between ui_begin and ui_end. In steady state there
+  // should be no misses and no bytes copied.
+  UI_Frame_Stats frame_stats;
+  u64 frame_start_pos;
   
   u64 current_build_index;
   
@@ -49,6 +49,7 @@ typedef struct
   s32 mouse_x, mouse_y, prev_mouse_x, prev_mouse_y;
 } OS_Input;
 
+#if !defined(DR_HEADLESS)
 typedef struct
 {
   HWND handle;
@@ -60,4 +61,5 @@ typedef struct
 function void  w32_prevent_dpi_scaling(void);
 function void  w32_create_window(OS_Window *window, char *name, s32 client_width, s32 client_height);
 function void  w32_fill_input(OS_Window *window);
+#endif
 #endif //WINDOWS_STUFF_H
\ No newline at end of file